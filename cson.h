@@ -6,8 +6,9 @@ BRIEF:
   A C library for serializing and deserializing json.
 
 NOTE:
-  Currently, this library assumes the JSON input is well-formed.
-  Invalid input will cause the program to abort, and duplicate keys are not handled.
+  The cson_load_xxx functions assume the JSON input is well-formed, invalid
+  input will cause the program to abort. cson_try_load_xxx and cson_validate
+  report an error instead. Duplicate keys are not handled.
 
 USAGE:
   In exactly one source file, define the implementation macro
@@ -66,22 +67,27 @@ LICENSE:
 #define CSONDEF
 #endif
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
-#include <ctype.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct cson_node cson_node_t;
+typedef struct cson_doc cson_doc_t;
+typedef struct cson_shared cson_shared_t;
+typedef struct cson_stream cson_stream_t;
 
+// Note: 32-bit counts keep a node at 32 bytes on 64-bit targets
 typedef struct {
     cson_node_t *items;
-    size_t len;
-    size_t cap;
+    uint32_t len;
+    uint32_t cap;
 } cson_nodes_t;
 
 typedef enum {
@@ -93,14 +99,45 @@ typedef enum {
     CSON_OBJECT
 } cson_node_kind_t;
 
+// node flags
+// CSON_FLAG_ARENA: key, string and items live in a document arena, so the
+//                  node is released by cson_doc_free, never by cson_free
+// CSON_FLAG_INTEGER: number node holds the exact value in as.integer
+// CSON_FLAG_INDEXED: object items are followed by a hash index of their keys
+// CSON_FLAG_KEY_INTERNED: key is owned by a cson_keytab_t
+// CSON_FLAG_LAZY: container is not parsed yet, as.lazy holds its text
+// CSON_FLAG_INLINE: string is stored in as.small instead of a separate buffer
+// CSON_FLAG_BORROWED: key and string belong to the caller, cson_free leaves them
+// CSON_FLAG_FROZEN: tree was passed to cson_freeze, functions that change it abort
+#define CSON_FLAG_ARENA (1u << 0)
+#define CSON_FLAG_INTEGER (1u << 1)
+#define CSON_FLAG_INDEXED (1u << 2)
+#define CSON_FLAG_KEY_INTERNED (1u << 3)
+#define CSON_FLAG_LAZY (1u << 4)
+#define CSON_FLAG_INLINE (1u << 5)
+#define CSON_FLAG_BORROWED (1u << 6)
+#define CSON_FLAG_FROZEN (1u << 7)
+
+// text of a container that is not parsed yet, allocated in the document arena
+typedef struct {
+    const char *start; // from the opening to the closing bracket
+    size_t len;
+    cson_doc_t *doc;   // document the children will be allocated in
+} cson_lazy_t;
+
+// Note: read strings through cson_to_string, short ones live in as.small
 struct cson_node {
     cson_node_kind_t kind;
+    unsigned int flags;
     char *key;
     union {
         bool boolean;
         double number;
+        int64_t integer;
         char *string;
+        char small[16]; // NUL-terminated string of at most 15 bytes
         cson_nodes_t container;
+        cson_lazy_t *lazy;
     } as;
 };
 
@@ -115,33 +152,314 @@ typedef enum {
 
 typedef struct {
     cson_token_kind_t kind;
+    bool escaped; // string text holds escape sequences
     const char *start;
     size_t len;
 } cson_token_t;
 
+typedef enum {
+    CSON_OK,
+    CSON_ERROR_FILE,       // file is empty or cannot be read
+    CSON_ERROR_CHARACTER,  // character that starts no token
+    CSON_ERROR_STRING,     // string without its closing '"'
+    CSON_ERROR_NUMBER,     // number that breaks the json grammar
+    CSON_ERROR_LITERAL,    // misspelled true, false or null
+    CSON_ERROR_SYNTAX,     // token in the wrong place
+    CSON_ERROR_EOF,        // text ends inside the root object
+    CSON_ERROR_TRAILING,   // text goes on after the root object
+    CSON_ERROR_DEPTH,      // containers nested deeper than CSON_MAX_DEPTH
+    CSON_ERROR_ESCAPE,     // bad escape sequence, raw control byte or \u0000 in a tree string
+    CSON_ERROR_UTF8        // string bytes that are not valid utf-8
+} cson_error_code_t;
+
+// where and why a text failed to parse
+typedef struct {
+    cson_error_code_t code;
+    size_t offset; // byte offset of the offending token
+    size_t line;   // 1-based line of offset
+    size_t column; // 1-based byte column of offset
+} cson_error_t;
+
 typedef struct {
     const char *start;
     const char *current;
+    const char *end;
+    bool partial;            // more input follows end, so a token reaching it is not complete
+    bool recover;            // record errors below instead of aborting
+    bool keep_nul;           // accept \u0000, the consumer carries string lengths
+    cson_error_code_t error; // first error met by a recovering lexer or parser
+    const char *error_at;    // where it was met
 } cson_lexer_t;
 
+// objects get a hash index once they have this many members
+#ifndef CSON_INDEX_THRESHOLD
+#define CSON_INDEX_THRESHOLD 8
+#endif
+
+// files at least this large are mapped instead of read by cson_load_file
+#ifndef CSON_MMAP_THRESHOLD
+#define CSON_MMAP_THRESHOLD (64*1024)
+#endif
+
+// parsers fail on containers nested deeper than this
+#ifndef CSON_MAX_DEPTH
+#define CSON_MAX_DEPTH 1024
+#endif
+
+#ifndef CSON_ARENA_BLOCK_SIZE
+#define CSON_ARENA_BLOCK_SIZE (64*1024)
+#endif
+
+// ndjson input is split into batches of about this many bytes, one per task
+#ifndef CSON_NDJSON_BATCH_SIZE
+#define CSON_NDJSON_BATCH_SIZE (1024*1024)
+#endif
+
+// table of canonical keys shared by many documents
+// Note: interning is lock-free, so several threads may load with one table,
+//       the capacity is fixed and keys beyond it are copied as usual
+typedef struct {
+    char **slots;
+    size_t cap;   // slot count, power of two
+    size_t count;
+} cson_keytab_t;
+
+typedef struct cson_arena_block cson_arena_block_t;
+
+struct cson_arena_block {
+    cson_arena_block_t *next;
+    size_t cap;
+    size_t used;
+};
+
+// bump allocator, blocks are kept on reset and reused by the next load
+typedef struct {
+    cson_arena_block_t *first;
+    cson_arena_block_t *cur;
+} cson_arena_t;
+
+// document whose whole tree is allocated from one arena
+// Note: zero-initialize it before the first load
+struct cson_doc {
+    cson_node_t root;
+    cson_arena_t arena;
+    char *source;        // file kept alive by in-situ and lazy loads (Nullable)
+    size_t source_len;
+    bool source_mapped;
+    cson_keytab_t *keys; // set by the caller to intern keys on load (Nullable)
+};
+
+// container still open in a push parser
+typedef struct {
+    cson_node_kind_t kind;
+    unsigned int key_flags;
+    char *key;   // key of the container itself (Nullable)
+    size_t base; // scratch stack length when it was opened
+} cson_push_frame_t;
+
+// resumable parser fed with the json text chunk by chunk
+// Note: zero-initialize it or call cson_parser_init before the first chunk
+typedef struct {
+    cson_nodes_t stack;        // finished children of the open containers
+    cson_push_frame_t *frames; // open containers, innermost last
+    size_t depth;
+    size_t frames_cap;
+    char *key;                 // key waiting for its value (Nullable)
+    unsigned int key_flags;
+    int state;                 // which token may come next
+    char *carry;               // start of a token cut by the end of the last chunk
+    size_t carry_len;
+    size_t carry_cap;
+    cson_node_t root;          // valid once cson_parser_done is true
+    cson_keytab_t *keys;       // set by the caller to intern keys (Nullable)
+} cson_parser_t;
+
+// cson_record_cb_t - receives the records of an ndjson input in order
+// @user: user pointer
+// @root: record root node, only valid during the call
+// @index: record number, blank lines are not counted
+// Return: false to stop loading
+typedef bool (*cson_record_cb_t)(void *user, const cson_node_t *root, size_t index);
+
+// options of the ndjson loader, zero-initialized means one worker per core
+typedef struct {
+    size_t threads;      // parsing threads (0 means one per online cpu)
+    size_t batch_size;   // bytes per batch (0 means CSON_NDJSON_BATCH_SIZE)
+    cson_keytab_t *keys; // intern keys into this shared table (Nullable)
+} cson_ndjson_opts_t;
+
+// event callbacks of cson_parse_events, every member is Nullable
+// Note: key and string text is decoded utf-8 and is not NUL-terminated, it
+//       points into the input unless it had escapes, then it is only valid
+//       during the call; escaped text that decodes to more than 252 bytes
+//       still reaches key or string whole, through a heap block if it is
+//       long, unless key_part or string_part is set: then every piece but the
+//       last goes to the part callback, in order, the last piece goes to key
+//       or string, and nothing is allocated; return false to stop parsing
+typedef struct {
+    bool (*start_object)(void *user);
+    bool (*end_object)(void *user);
+    bool (*start_array)(void *user);
+    bool (*end_array)(void *user);
+    bool (*key)(void *user, const char *key, size_t len);
+    bool (*string)(void *user, const char *value, size_t len);
+    bool (*number)(void *user, double value);
+    bool (*integer)(void *user, int64_t value); // integers that fit int64, number is used if NULL
+    bool (*boolean)(void *user, bool value);
+    bool (*null)(void *user);
+    bool (*key_part)(void *user, const char *key, size_t len);      // leading pieces of a long key
+    bool (*string_part)(void *user, const char *value, size_t len); // leading pieces of a long string
+} cson_handler_t;
+
+// read-only document stored as one flat array of 64-bit words
+// Note: zero-initialize it before the first load, every value is one word
+//       (a number takes one more for its bits) tagged in the top byte,
+//       a container word holds the index behind its closing word so a sibling
+//       is one jump away, keys and strings live in a separate buffer
+typedef struct {
+    uint64_t *words;
+    size_t len;
+    size_t cap;
+    char *strings;      // length-prefixed, NUL-terminated, decoded utf-8
+    size_t strings_len;
+    size_t strings_cap;
+    char *source;       // binary file that words and strings point into (Nullable)
+    size_t source_len;
+    bool source_mapped;
+} cson_tape_t;
+
+// handle on a value of a tape, two registers wide so it is passed by value
+typedef struct {
+    const cson_tape_t *tape; // NULL if the value does not exist
+    uint32_t idx;            // word of the value
+    uint32_t key;            // word of its key, 0 for the root and array elements
+} cson_tape_ref_t;
+
+// one step of a compiled path
+typedef struct {
+    char *key;     // member key, NULL if the step only indexes arrays
+    size_t len;    // key length
+    uint32_t hash; // key hash, matches the object index
+    size_t idx;    // array index, SIZE_MAX if the step is not a number
+} cson_path_step_t;
+
+// path compiled once by cson_path_compile and run on many documents
+typedef struct {
+    cson_path_step_t *steps;
+    size_t len;
+} cson_path_t;
+
+// C type a schema field is written as
+typedef enum {
+    CSON_FIELD_BOOLEAN, // bool
+    CSON_FIELD_INT64,   // int64_t, converted like cson_to_int64
+    CSON_FIELD_DOUBLE,  // double
+    CSON_FIELD_STRING,  // char *, NULL or a heap copy released by the caller with free (or CSON_FREE)
+    CSON_FIELD_CHARS,   // char[size], truncated to fit and always NUL-terminated
+    CSON_FIELD_OBJECT   // nested struct described by another schema
+} cson_field_kind_t;
+
+typedef struct cson_schema cson_schema_t;
+
+// one member of a known document shape
+typedef struct {
+    const char *key;             // member key as written in the json text
+    cson_field_kind_t kind;
+    size_t offset;               // offsetof the field in the target struct
+    size_t size;                 // sizeof the field
+    const cson_schema_t *schema; // members of a CSON_FIELD_OBJECT (Nullable)
+} cson_field_t;
+
+// known document shape, at most 64 fields per object
+struct cson_schema {
+    const cson_field_t *fields;
+    size_t len;
+};
+
+// CSON_FIELD - describe the member of a struct
+// @type: struct type
+// @member: member name, also used as the json key
+// @kind: cson_field_kind_t matching the member type
+#define CSON_FIELD(type, member, kind) \
+    { #member, (kind), offsetof(type, member), sizeof(((type *) 0)->member), NULL }
+
+// CSON_SCHEMA - initializer of a schema over a field array
+// @fields: array of cson_field_t (not a pointer)
+#define CSON_SCHEMA(fields) { (fields), sizeof(fields)/sizeof((fields)[0]) }
+
+// CSON_FIELD_NESTED - describe a struct member filled by another schema
+// @type: struct type
+// @member: member name, also used as the json key
+// @schema: pointer to the schema of the member type
+#define CSON_FIELD_NESTED(type, member, schema) \
+    { #member, CSON_FIELD_OBJECT, offsetof(type, member), sizeof(((type *) 0)->member), (schema) }
+
+// cson_sink_t - output callback of the writer
+// @user: user pointer
+// @data: bytes to write
+// @len: byte count
+// Return: false to report a write error
+typedef bool (*cson_sink_t)(void *user, const char *data, size_t len);
+
+// output options of the writer, zero-initialized means pretty-print
+typedef struct {
+    bool compact;  // no whitespace at all
+    size_t indent; // spaces per level when not compact (0 means 4)
+} cson_write_opts_t;
+
 // cson_append - append item to node
 // @node: must be object or array
 // @item: new item
 CSONDEF void cson_append(cson_node_t *node, cson_node_t item);
 
+// cson_append_many - append several items at once
+// @node: must be object or array
+// @items: new items, node takes them over like cson_append
+// @n: item count
+// Note: the allocation grows at most once
+CSONDEF void cson_append_many(cson_node_t *node, const cson_node_t *items, size_t n);
+
+// cson_append_new - append an empty item and fill it in place
+// @node: must be object or array
+// @kind: item type
+// @key: member key, copied like cson_create_xxx (Nullable)
+// Note: the pointer is valid until node grows or loses items, a string set
+//       in as.string must come from CSON_MALLOC
+// Return: the new item with a zeroed value
+CSONDEF cson_node_t *cson_append_new(cson_node_t *node, cson_node_kind_t kind, const char *key);
+
+// cson_reserve - make room for items ahead of appending them
+// @node: must be object or array
+// @cap: item count that fits without another allocation
+CSONDEF void cson_reserve(cson_node_t *node, size_t cap);
+
 // cson_remove_with_key - remove item from node on key
 // @node: must be object
 // @key: removed node key (should not be NULL)
-// Note: uses swap-and-pop deletion, which does not preserve element order
+// Note: the removed item is released with cson_free and the following
+//       items move down, so order is kept but the cost is linear,
+//       use cson_remove_if for many removals
 CSONDEF void cson_remove_with_key(cson_node_t *node, const char *key);
 
 // cson_remove_with_idx - remove item from node on index
 // @node: must be array
-// @key: removed node index
-// Note: uses swap-and-pop deletion, which does not preserve element order
+// @idx: removed node index
+// Note: same as cson_remove_with_key
 CSONDEF void cson_remove_with_idx(cson_node_t *node, size_t idx);
 
-// cson_remove_all - remove all item from node
+// predicate of cson_remove_if, return true to remove item
+typedef bool (*cson_pred_t)(void *user, const cson_node_t *item);
+
+// cson_remove_if - remove every item a predicate selects
+// @node: must be object or array
+// @pred: predicate called once per item in order
+// @user: passed to pred
+// Note: one pass compacts the kept items in place, in order, and releases
+//       the removed ones with cson_free
+// Return: number of removed items
+CSONDEF size_t cson_remove_if(cson_node_t *node, cson_pred_t pred, void *user);
+
+// cson_remove_all - remove and release all items of node
 // @node: must be object or array
 CSONDEF void cson_remove_all(cson_node_t *node);
 
@@ -149,10 +467,24 @@ CSONDEF void cson_remove_all(cson_node_t *node);
 CSONDEF cson_node_t cson_create_object(const char *key);
 CSONDEF cson_node_t cson_create_array(const char *key);
 CSONDEF cson_node_t cson_create_number(const char *key, double value);
+CSONDEF cson_node_t cson_create_int64(const char *key, int64_t value);
 CSONDEF cson_node_t cson_create_boolean(const char *key, bool value);
 CSONDEF cson_node_t cson_create_string(const char *key, const char *value);
 CSONDEF cson_node_t cson_create_null(const char *key);
 
+// cson_create_string_owned - create a string node from heap strings without copying
+// @key: member key allocated with CSON_MALLOC (Nullable)
+// @value: string allocated with CSON_MALLOC (Nullable)
+// Note: the node takes both over and cson_free releases them
+CSONDEF cson_node_t cson_create_string_owned(char *key, char *value);
+
+// cson_create_string_ref - create a string node that borrows its key and value
+// @key: member key (Nullable)
+// @value: string (Nullable)
+// Note: nothing is copied or freed (CSON_FLAG_BORROWED), so both must outlive
+//       the node, e.g. literals, keytab keys or strings of an arena document
+CSONDEF cson_node_t cson_create_string_ref(const char *key, const char *value);
+
 // cson_load_buffer - load the json string from buffer
 // @buffer: json string (should not be NULL)
 // Note: the input json must be valid
@@ -161,565 +493,6663 @@ CSONDEF cson_node_t cson_load_buffer(const char *buffer);
 
 // cson_load_file - load the json file
 // @path: json file path (should not be NULL)
-// Note: the input json must be valid
+// Note: the input json must be valid, large files are memory-mapped
+//       (define CSON_NO_MMAP to always read them)
 // Return: root node (always valid)
 CSONDEF cson_node_t cson_load_file(const char *path);
 
+// cson_try_load_buffer - load the json string without aborting on bad input
+// @buffer: json text (should not be NULL)
+// @len: text length
+// @root: receives the root node, zeroed on error (should not be NULL)
+// @err: receives the error (Nullable)
+// Note: the text is parsed once, errors only cost something when they happen,
+//       text after the root object is an error here unlike in cson_load_buffer
+// Return: false if the text is not valid json
+CSONDEF bool cson_try_load_buffer(const char *buffer, size_t len, cson_node_t *root, cson_error_t *err);
+
+// cson_try_load_file - load the json file without aborting on bad input
+// @path: json file path (should not be NULL)
+// @root: receives the root node, zeroed on error (should not be NULL)
+// @err: receives the error (Nullable)
+// Return: false if the file cannot be read or is not valid json
+CSONDEF bool cson_try_load_file(const char *path, cson_node_t *root, cson_error_t *err);
+
+// cson_try_load_buffer_arena - load the json string into an arena document without aborting
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @buffer: json text (should not be NULL)
+// @len: text length
+// @err: receives the error (Nullable)
+// Return: root node owned by doc, NULL if the text is not valid json
+CSONDEF cson_node_t *cson_try_load_buffer_arena(cson_doc_t *doc, const char *buffer, size_t len,
+                                              cson_error_t *err);
+
+// cson_validate - check that a text is one well-formed json object
+// @buffer: json text (should not be NULL)
+// @len: text length
+// @err: receives the error (Nullable)
+// Note: nothing is allocated unless containers nest deeper than 256,
+//       the rules are the ones of cson_try_load_buffer, CSON_MAX_DEPTH included
+// Return: true if cson_try_load_buffer would succeed
+CSONDEF bool cson_validate(const char *buffer, size_t len, cson_error_t *err);
+
+// cson_error_string - describe an error code
+// @code: error code
+// Return: static text
+CSONDEF const char *cson_error_string(cson_error_code_t code);
+
+// cson_load_buffer_arena - load the json string into an arena document
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @buffer: json string (should not be NULL)
+// Note: the previous tree of doc is discarded but its blocks are reused,
+//       the returned tree must not be passed to cson_free or cson_append
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_buffer_arena(cson_doc_t *doc, const char *buffer);
+
+// cson_load_file_arena - load the json file into an arena document
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @path: json file path (should not be NULL)
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_file_arena(cson_doc_t *doc, const char *path);
+
+// cson_load_buffer_insitu - load the json string in place into an arena document
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @buffer: mutable json string (should not be NULL)
+// Note: keys and strings are not copied, they point into buffer and are
+//       terminated by overwriting their closing '"', so buffer must outlive doc
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_buffer_insitu(cson_doc_t *doc, char *buffer);
+
+// cson_load_file_insitu - load the json file in place into an arena document
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @path: json file path (should not be NULL)
+// Note: the file buffer is owned by doc and released by cson_doc_free
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_file_insitu(cson_doc_t *doc, const char *path);
+
+// cson_load_buffer_lazy - load the json string into an arena document on demand
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @buffer: json string (should not be NULL)
+// Note: only the members of the root object are parsed, a nested object or array
+//       just records its text (CSON_FLAG_LAZY) and is parsed one level deep when
+//       cson_query, cson_to_object, cson_to_array or cson_write first reaches it,
+//       so buffer must outlive doc, doc must not move, and errors inside a
+//       container are only found when it is parsed
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_buffer_lazy(cson_doc_t *doc, const char *buffer);
+
+// cson_load_file_lazy - load the json file into an arena document on demand
+// @doc: zero-initialized or previously used document (should not be NULL)
+// @path: json file path (should not be NULL)
+// Note: the file stays mapped or read until cson_doc_free
+// Return: root node owned by doc (always valid)
+CSONDEF cson_node_t *cson_load_file_lazy(cson_doc_t *doc, const char *path);
+
+// cson_load_buffer_parallel - load a large json string on several threads
+// @buffer: json string (should not be NULL)
+// @len: string length
+// @threads: parsing threads (0 means one per online cpu)
+// Note: one pass over the text cuts the members of the root object, and the
+//       elements of its large object and array members, into ranges that a
+//       thread pool parses while the pass goes on, the tree is identical to
+//       the one of cson_load_buffer and released by cson_free, link with
+//       -pthread unless CSON_NO_THREADS is defined (then it is sequential)
+// Return: root node (always valid)
+CSONDEF cson_node_t cson_load_buffer_parallel(const char *buffer, size_t len, size_t threads);
+
+// cson_load_file_parallel - load a large json file on several threads
+// @path: json file path (should not be NULL)
+// @threads: parsing threads (0 means one per online cpu)
+// Return: root node (always valid)
+CSONDEF cson_node_t cson_load_file_parallel(const char *path, size_t threads);
+
+// cson_parser_init - prepare a push parser
+// @p: parser (should not be NULL)
+CSONDEF void cson_parser_init(cson_parser_t *p);
+
+// cson_parser_feed - parse the next chunk of json text
+// @p: parser (should not be NULL)
+// @chunk: bytes, not NUL-terminated, may start or end inside a token
+// @len: byte count
+// Note: chunk is not referenced after the call, only a token cut by its end
+//       is copied until the next chunk completes it, input after the root
+//       object is ignored like in cson_load_buffer
+CSONDEF void cson_parser_feed(cson_parser_t *p, const char *chunk, size_t len);
+
+// cson_parser_done - check whether the root object is complete
+// @p: parser (should not be NULL)
+// Return: true once the closing '}' of the root object has been fed
+CSONDEF bool cson_parser_done(const cson_parser_t *p);
+
+// cson_parser_finish - end the input and take the tree
+// @p: parser (should not be NULL)
+// Note: abort if the root object is incomplete, p is then ready for the
+//       next document and keeps its key table
+// Return: root node (always valid)
+CSONDEF cson_node_t cson_parser_finish(cson_parser_t *p);
+
+// cson_parser_free - discard a parser and the partial tree it holds
+// @p: parser (Nullable)
+CSONDEF void cson_parser_free(cson_parser_t *p);
+
+// cson_parse_events - parse json text into callbacks without building a tree
+// @buffer: json text (should not be NULL)
+// @len: text length
+// @handler: callbacks (should not be NULL)
+// @user: passed to every callback
+// Note: the input json must be valid, nothing is allocated while parsing
+//       unless a long escaped key or string has no part callback, see
+//       cson_handler_t, and a \u0000 reaches the callbacks as a NUL byte
+// Return: false if a callback stopped the parse
+CSONDEF bool cson_parse_events(const char *buffer, size_t len, const cson_handler_t *handler, void *user);
+
+// cson_parse_events_file - parse the json file into callbacks
+// @path: json file path (should not be NULL)
+// @handler: callbacks (should not be NULL)
+// @user: passed to every callback
+// Note: large files are memory-mapped like in cson_load_file
+// Return: false if a callback stopped the parse
+CSONDEF bool cson_parse_events_file(const char *path, const cson_handler_t *handler, void *user);
+
+// cson_parse_schema - parse json text straight into a struct
+// @buffer: json text (should not be NULL)
+// @len: text length
+// @schema: shape of the root object (should not be NULL)
+// @out: struct the fields are written into (should not be NULL)
+// Note: no node is built, members missing from schema and members whose value
+//       has another type are skipped without being parsed (nor validated),
+//       fields that are not in the text keep their previous value, a
+//       CSON_FIELD_STRING that is written frees the string it held, so it
+//       must start as NULL and a struct can be reused for the next record,
+//       and if a key repeats the last value wins
+// Return: bit i is set if schema->fields[i] was written
+CSONDEF uint64_t cson_parse_schema(const char *buffer, size_t len, const cson_schema_t *schema, void *out);
+
+// cson_parse_schema_file - parse the json file straight into a struct
+// @path: json file path (should not be NULL)
+// @schema: shape of the root object (should not be NULL)
+// @out: struct the fields are written into (should not be NULL)
+// Note: large files are memory-mapped like in cson_load_file
+// Return: bit i is set if schema->fields[i] was written
+CSONDEF uint64_t cson_parse_schema_file(const char *path, const cson_schema_t *schema, void *out);
+
+// cson_tape_load_buffer - load the json string into a tape
+// @tape: zero-initialized or previously used tape (should not be NULL)
+// @buffer: json string (should not be NULL)
+// Note: the input json must be valid, the previous document of tape is
+//       discarded but its memory is reused, buffer is not referenced afterwards
+// Return: root object of the tape
+CSONDEF cson_tape_ref_t cson_tape_load_buffer(cson_tape_t *tape, const char *buffer);
+
+// cson_tape_load_file - load the json file into a tape
+// @tape: zero-initialized or previously used tape (should not be NULL)
+// @path: json file path (should not be NULL)
+// Note: large files are memory-mapped like in cson_load_file
+// Return: root object of the tape
+CSONDEF cson_tape_ref_t cson_tape_load_file(cson_tape_t *tape, const char *path);
+
+// cson_tape_from_node - copy a tree into a tape
+// @tape: zero-initialized or previously used tape (should not be NULL)
+// @root: root node (should be a object node)
+// Note: lazy containers of root are parsed on the way
+// Return: root object of the tape
+CSONDEF cson_tape_ref_t cson_tape_from_node(cson_tape_t *tape, const cson_node_t *root);
+
+// cson_tape_load_binary - use a file written by cson_generate_binary in place
+// @tape: zero-initialized or previously used tape (should not be NULL)
+// @path: binary file path (should not be NULL)
+// Note: nothing is parsed or copied, large files are memory-mapped and the
+//       tape reads the mapping until cson_tape_free or the next load, abort
+//       if the file was not written by the same format version or byte order,
+//       or if one linear pass over the words finds a container, key or string
+//       that does not fit the file
+// Return: root object of the tape
+CSONDEF cson_tape_ref_t cson_tape_load_binary(cson_tape_t *tape, const char *path);
+
+// cson_tape_generate_binary - output a tape into a binary file (create if not exists)
+// @tape: loaded tape (should not be NULL)
+// @path: file path
+// Note: the file holds a small header and then the words and strings as they are
+//       in memory, so it only loads on targets of the same byte order
+CSONDEF void cson_tape_generate_binary(const cson_tape_t *tape, const char *path);
+
+// cson_tape_free - release the words and strings of a tape
+// @tape: tape (Nullable)
+CSONDEF void cson_tape_free(cson_tape_t *tape);
+
+// cson_tape_root - get the root object of a loaded tape
+// @tape: tape (should not be NULL)
+CSONDEF cson_tape_ref_t cson_tape_root(const cson_tape_t *tape);
+
+// cson_tape_kind - get the type of a tape value
+// @ref: existing value
+CSONDEF cson_node_kind_t cson_tape_kind(cson_tape_ref_t ref);
+
+// cson_tape_query - get the member of an object with key
+// @ref: object value
+// @key: member key (should not be NULL)
+// Note: like cson_query, only query one layer and return the first match
+// Return: the member, its tape is NULL if not exists
+CSONDEF cson_tape_ref_t cson_tape_query(cson_tape_ref_t ref, const char *key);
+
+// cson_tape_len - get the member count of an object or array
+// @ref: object or array value
+CSONDEF size_t cson_tape_len(cson_tape_ref_t ref);
+
+// cson_tape_at - get the member of an object or array on index
+// @ref: object or array value
+// @idx: member index
+// Note: members are reached by jumping over their siblings, so walk long
+//       containers with cson_tape_first and cson_tape_next instead
+// Return: the member, its tape is NULL if idx is out of range
+CSONDEF cson_tape_ref_t cson_tape_at(cson_tape_ref_t ref, size_t idx);
+
+// cson_tape_first - get the first member of an object or array
+// @ref: object or array value
+// Return: the member, its tape is NULL if the container is empty
+CSONDEF cson_tape_ref_t cson_tape_first(cson_tape_ref_t ref);
+
+// cson_tape_next - get the next sibling of a member
+// @ref: member got from cson_tape_first or cson_tape_next
+// Return: the sibling, its tape is NULL after the last member
+CSONDEF cson_tape_ref_t cson_tape_next(cson_tape_ref_t ref);
+
+// cson_tape_key - get the key of an object member
+// @ref: existing value
+// Return: NUL-terminated key in the tape, NULL for the root and array elements
+CSONDEF const char *cson_tape_key(cson_tape_ref_t ref);
+
+// cson_tape_to_xxx - get the tape value
+// Note: same conversions and checks as cson_to_xxx, strings stay in the tape
+CSONDEF double cson_tape_to_number(cson_tape_ref_t ref);
+CSONDEF int64_t cson_tape_to_int64(cson_tape_ref_t ref);
+CSONDEF bool cson_tape_to_boolean(cson_tape_ref_t ref);
+CSONDEF const char *cson_tape_to_string(cson_tape_ref_t ref);
+
+// cson_tape_to_node - copy a tape value into a mutable tree
+// @ref: existing value
+// Note: the key of a member is copied too
+// Return: node released by cson_free (always valid)
+CSONDEF cson_node_t cson_tape_to_node(cson_tape_ref_t ref);
+
+// cson_load_ndjson - load newline-delimited json, one object per line
+// @buffer: ndjson text (should not be NULL)
+// @len: text length
+// @opts: loader options (Nullable)
+// @cb: called for every record in input order, always on the calling thread
+// @user: passed to cb
+// Note: the input is cut into batches of whole lines that are parsed in parallel,
+//       each into its own arena, up to two batches per thread are kept ahead of cb,
+//       link with -pthread, or define CSON_NO_THREADS (implied on non-POSIX
+//       targets) to parse on the calling thread only
+// Return: false if cb stopped the loading
+CSONDEF bool cson_load_ndjson(const char *buffer, size_t len, const cson_ndjson_opts_t *opts,
+                              cson_record_cb_t cb, void *user);
+
+// cson_load_ndjson_file - load a newline-delimited json file
+// @path: ndjson file path (should not be NULL)
+// @opts: loader options (Nullable)
+// @cb: called for every record in input order
+// @user: passed to cb
+// Note: large files are memory-mapped like in cson_load_file
+// Return: false if cb stopped the loading
+CSONDEF bool cson_load_ndjson_file(const char *path, const cson_ndjson_opts_t *opts,
+                                   cson_record_cb_t cb, void *user);
+
+// cson_keytab_init - create a key table
+// @keys: table to initialize (should not be NULL)
+// @capacity: expected number of distinct keys
+CSONDEF void cson_keytab_init(cson_keytab_t *keys, size_t capacity);
+
+// cson_keytab_free - release a key table and all its keys
+// @keys: table (Nullable)
+// Note: every node holding one of its keys must be freed before
+CSONDEF void cson_keytab_free(cson_keytab_t *keys);
+
+// cson_keytab_intern - get the canonical pointer of a key
+// @keys: table (should not be NULL)
+// @key: key text (should not be NULL)
+// Note: safe to call from several threads at once
+// Return: canonical key, NULL if the table is full
+CSONDEF const char *cson_keytab_intern(cson_keytab_t *keys, const char *key);
+
+// cson_intern_keys - replace every key in a tree by its canonical pointer
+// @root: root node
+// @keys: table (should not be NULL)
+// Note: use it on trees built by cson_create_xxx or cson_load_buffer,
+//       keys that do not fit in the table are left untouched
+CSONDEF void cson_intern_keys(cson_node_t *root, cson_keytab_t *keys);
+
+// cson_doc_free - release the whole tree and every arena block of doc
+// @doc: document (Nullable)
+CSONDEF void cson_doc_free(cson_doc_t *doc);
+
+// cson_freeze - make a tree read-only so that many threads can read it
+// @root: root node
+// Note: lazy containers are parsed now and every node gets CSON_FLAG_FROZEN,
+//       after that the read functions (cson_query, cson_to_xxx, paths,
+//       cson_write, cson_diff) write nothing into the tree and need no lock,
+//       while appending, removing, patching and interning abort
+CSONDEF void cson_freeze(cson_node_t *root);
+
+// cson_share - turn a heap tree into a reference counted document
+// @root: tree built by cson_load_buffer or cson_create_xxx, zeroed here
+// Note: the tree is frozen and owned by the handle from now on
+// Return: handle with one reference
+CSONDEF cson_shared_t *cson_share(cson_node_t *root);
+
+// cson_share_doc - turn an arena document into a reference counted document
+// @doc: document, zeroed here
+// Note: same as cson_share, a keytab the document was interned with must
+//       outlive the handle
+// Return: handle with one reference
+CSONDEF cson_shared_t *cson_share_doc(cson_doc_t *doc);
+
+// cson_shared_sub - share a subtree of a shared document
+// @doc: shared document
+// @node: node inside the tree of doc
+// Note: the view holds a reference on doc, so it stays valid on its own
+// Return: handle with one reference, its root is node
+CSONDEF cson_shared_t *cson_shared_sub(cson_shared_t *doc, const cson_node_t *node);
+
+// cson_shared_root - get the frozen tree of a shared document
+// @doc: shared document
+// Return: root node
+CSONDEF const cson_node_t *cson_shared_root(const cson_shared_t *doc);
+
+// cson_shared_retain - take one more reference
+// @doc: shared document
+// Note: atomic, any thread holding a reference may call it
+// Return: doc
+CSONDEF cson_shared_t *cson_shared_retain(cson_shared_t *doc);
+
+// cson_shared_release - drop a reference, the last one frees the document
+// @doc: shared document (Nullable)
+CSONDEF void cson_shared_release(cson_shared_t *doc);
+
+// current shared document of a value read by many threads and replaced
+// by cson_rcu_swap while they run
+// Note: an acquire is a few atomic operations and never waits, a swap waits
+//       only for the acquires already reading the old pointer
+typedef struct {
+    cson_shared_t *current;
+    size_t readers[2]; // acquires running in each epoch
+    size_t epoch;
+    size_t writer;     // swaps running, they take turns
+} cson_rcu_t;
+
+// cson_rcu_init - publish a first document
+// @rcu: slot
+// @doc: shared document, its reference is taken over (Nullable)
+CSONDEF void cson_rcu_init(cson_rcu_t *rcu, cson_shared_t *doc);
+
+// cson_rcu_acquire - get the current document
+// @rcu: slot
+// Note: the reference stays valid across later swaps until it is released
+// Return: current document with one reference for the caller, NULL if none
+CSONDEF cson_shared_t *cson_rcu_acquire(cson_rcu_t *rcu);
+
+// cson_rcu_swap - publish a new document
+// @rcu: slot
+// @doc: shared document, its reference is taken over (Nullable)
+// Note: readers that acquired the old one keep it until they release it
+CSONDEF void cson_rcu_swap(cson_rcu_t *rcu, cson_shared_t *doc);
+
+// cson_rcu_free - release the current document
+// @rcu: slot, no thread may use it anymore
+CSONDEF void cson_rcu_free(cson_rcu_t *rcu);
+
 // cson_write - output the nodes tree into file pointer
 // @root: root node (should be a object node)
 // @f: output file pointer
+// Note: keys and strings are plain utf-8 in the tree and get their json
+//       escapes here, an object member without a key is written as ""
 CSONDEF void cson_write(const cson_node_t *root, FILE *f);
 
+// cson_write_ex - output the nodes tree into file pointer with options
+// @root: root node (should be a object node)
+// @f: output file pointer
+// @opts: output options (Nullable, pretty-print with four spaces)
+CSONDEF void cson_write_ex(const cson_node_t *root, FILE *f, const cson_write_opts_t *opts);
+
+// cson_write_to_sink - output the nodes tree through a sink callback
+// @root: root node (should be a object node)
+// @sink: output callback, called with chunks of CSON_WRITE_BUFFER_SIZE bytes
+// @user: passed to sink
+// @opts: output options (Nullable)
+// Return: false if sink reported an error
+CSONDEF bool cson_write_to_sink(const cson_node_t *root, cson_sink_t sink, void *user,
+                                const cson_write_opts_t *opts);
+
+// cson_write_to_buffer - output the nodes tree into memory
+// @root: root node (should be a object node)
+// @len: output length without the terminator (Nullable)
+// @opts: output options (Nullable)
+// Return: NUL-terminated json text, release it with free (CSON_FREE if it is redefined)
+CSONDEF char *cson_write_to_buffer(const cson_node_t *root, size_t *len, const cson_write_opts_t *opts);
+
+// cson_write_fd - output the nodes tree straight into a file descriptor
+// @root: root node (should be a object node)
+// @fd: open descriptor, e.g. a socket
+// @opts: output options (Nullable)
+// Return: false on write error
+CSONDEF bool cson_write_fd(const cson_node_t *root, int fd, const cson_write_opts_t *opts);
+
 // cson_generate_file - output to a file (create if not exists)
 // @root: root node (should be a object node)
 // @path: file path
 CSONDEF void cson_generate_file(const cson_node_t *root, const char *path);
 
+// cson_generate_file_ex - output to a file with options
+// @root: root node (should be a object node)
+// @path: file path
+// @opts: output options (Nullable)
+CSONDEF void cson_generate_file_ex(const cson_node_t *root, const char *path,
+                                   const cson_write_opts_t *opts);
+
+// cson_stream_open - start writing a document without building a tree
+// @sink: output callback, called with chunks of CSON_WRITE_BUFFER_SIZE bytes
+// @user: passed to sink
+// @opts: output options (Nullable)
+// Note: memory only grows with the nesting depth, never with the output,
+//       the layout is the same as cson_write_to_sink, keys and strings are
+//       escaped, calls out of order (e.g. a value where a key is expected,
+//       or a mismatched end) abort
+// Return: stream, finish it with cson_stream_close
+CSONDEF cson_stream_t *cson_stream_open(cson_sink_t sink, void *user, const cson_write_opts_t *opts);
+
+// cson_stream_open_file - start writing a document into a file pointer
+// @f: output file pointer
+// @opts: output options (Nullable)
+// Return: stream, finish it with cson_stream_close
+CSONDEF cson_stream_t *cson_stream_open_file(FILE *f, const cson_write_opts_t *opts);
+
+// cson_stream_xxx - write one token of the document
+// Note: cson_stream_key comes before every value of an object, a NULL key
+//       is written as "" and a NULL string as null, cson_stream_node writes
+//       a whole tree as one value
+CSONDEF void cson_stream_begin_object(cson_stream_t *s);
+CSONDEF void cson_stream_end_object(cson_stream_t *s);
+CSONDEF void cson_stream_begin_array(cson_stream_t *s);
+CSONDEF void cson_stream_end_array(cson_stream_t *s);
+CSONDEF void cson_stream_key(cson_stream_t *s, const char *key);
+CSONDEF void cson_stream_string(cson_stream_t *s, const char *value);
+CSONDEF void cson_stream_string_n(cson_stream_t *s, const char *value, size_t len);
+CSONDEF void cson_stream_number(cson_stream_t *s, double value);
+CSONDEF void cson_stream_int64(cson_stream_t *s, int64_t value);
+CSONDEF void cson_stream_boolean(cson_stream_t *s, bool value);
+CSONDEF void cson_stream_null(cson_stream_t *s);
+CSONDEF void cson_stream_node(cson_stream_t *s, const cson_node_t *node);
+
+// cson_stream_close - flush and release a stream
+// @s: stream
+// Return: false if the sink reported an error or the document is not complete
+CSONDEF bool cson_stream_close(cson_stream_t *s);
+
+// cson_generate_binary - output the nodes tree into a binary file
+// @root: root node (should be a object node)
+// @path: file path
+// Note: the tree is written as a tape, see cson_tape_generate_binary
+CSONDEF void cson_generate_binary(const cson_node_t *root, const char *path);
+
+// cson_load_binary - load a file written by cson_generate_binary
+// @path: binary file path (should not be NULL)
+// Note: no json text is parsed, use cson_tape_load_binary to read the
+//       values in place without building a tree at all
+// Return: root node (always valid)
+CSONDEF cson_node_t cson_load_binary(const char *path);
+
 // cson_free - free the memory
 // @root: root node
 CSONDEF void cson_free(cson_node_t *root);
 
+// cson_clone - deep copy a node
+// @node: node of any tree, arena and lazy ones included
+// Return: heap copy with its own key, release it with cson_free
+CSONDEF cson_node_t cson_clone(const cson_node_t *node);
+
 // cson_query - get the node pointer with key
 // @root: root node (should be object)
 // @key: member key (should not be NULL)
-// Note: only query one layer, and just return the first matched result
+// Note: only query one layer, and just return the first matched result,
+//       objects with CSON_INDEX_THRESHOLD or more members are looked up by hash,
+//       a canonical key from cson_keytab_intern matches by pointer first
 // Return: the node pointer, NULL if not exists
 CSONDEF cson_node_t *cson_query(const cson_node_t *root, const char *key);
 
 // cson_to_xxx - get the node value
+// Note: cson_to_int64 is exact for integer literals that fit int64,
+//       other numbers are truncated toward zero and saturated to its range
 CSONDEF cson_nodes_t cson_to_object(const cson_node_t *node);
 CSONDEF cson_nodes_t cson_to_array(const cson_node_t *node);
 CSONDEF double cson_to_number(const cson_node_t *node);
+CSONDEF int64_t cson_to_int64(const cson_node_t *node);
 CSONDEF bool cson_to_boolean(const cson_node_t *node);
 CSONDEF const char *cson_to_string(const cson_node_t *node);
 
+// cson_path_compile - split a path into steps
+// @path: JSON Pointer ("/address/coordinates/lat", "" is the root itself) or
+//        dotted path ("address.coordinates.lat", "skills[1].name")
+// Note: abort on a malformed path, a step made of digits both indexes an array
+//       and names an object member, keys holding '.' or '[' need a JSON Pointer
+// Return: compiled path, release it with cson_path_free
+CSONDEF cson_path_t cson_path_compile(const char *path);
+
+// cson_path_eval - run a compiled path on a tree
+// @path: compiled path (should not be NULL)
+// @root: start node
+// Note: lazy containers on the way are parsed, keys are looked up with the
+//       hashes computed at compile time
+// Return: the node pointer, NULL if a step does not exist
+CSONDEF cson_node_t *cson_path_eval(const cson_path_t *path, const cson_node_t *root);
+
+// cson_tape_path_eval - run a compiled path on a tape
+// @path: compiled path (should not be NULL)
+// @root: start value
+// Return: the value, its tape is NULL if a step does not exist
+CSONDEF cson_tape_ref_t cson_tape_path_eval(const cson_path_t *path, cson_tape_ref_t root);
+
+// cson_path_free - release a compiled path
+// @path: compiled path (Nullable)
+CSONDEF void cson_path_free(cson_path_t *path);
+
+// cson_query_path - compile and run a path once
+// @root: start node
+// @path: path, see cson_path_compile
+// Return: the node pointer, NULL if not exists
+CSONDEF cson_node_t *cson_query_path(const cson_node_t *root, const char *path);
+
+// cson_diff - compute the JSON Patch (RFC 6902) that turns one tree into another
+// @from: old tree
+// @to: new tree
+// Note: both trees are hashed once and subtrees with the same hash and value
+//       are skipped, objects are matched by key, arrays by position once
+//       their common head and tail are cut off, so one inserted or removed
+//       element costs one operation
+// Return: array of add, remove and replace operations, empty if the trees are equal
+CSONDEF cson_node_t cson_diff(const cson_node_t *from, const cson_node_t *to);
+
+// cson_patch_apply - apply a JSON Patch in place
+// @root: tree to change, not an arena document
+// @patch: array of add, remove, replace, move, copy and test operations
+// Note: stops at the first operation that fails (malformed, missing path,
+//       index out of range or failed test), the ones before it stay applied
+// Return: true if every operation was applied
+CSONDEF bool cson_patch_apply(cson_node_t *root, const cson_node_t *patch);
+
+// cson_merge_diff - compute the JSON Merge Patch (RFC 7396) between two objects
+// @from: old tree
+// @to: new tree
+// Note: arrays are replaced whole, and as a null member means removal in a
+//       merge patch, null values of to cannot be expressed, use cson_diff then
+// Return: object holding the changed members, empty if the trees are equal
+CSONDEF cson_node_t cson_merge_diff(const cson_node_t *from, const cson_node_t *to);
+
+// cson_merge_apply - apply a JSON Merge Patch in place
+// @root: tree to change, not an arena document
+// @patch: merge patch, a non-object patch replaces root
+CSONDEF void cson_merge_apply(cson_node_t *root, const cson_node_t *patch);
+
+// counters of the calling thread, collected when the implementation is
+// compiled with CSON_ENABLE_STATS, ndjson and parallel workers count on
+// their own threads
+typedef struct {
+    size_t allocations;  // CSON_MALLOC and CSON_REALLOC calls
+    size_t bytes;        // bytes requested by them
+    size_t nodes;        // nodes built by the parsers and cson_create_xxx
+    size_t peak_depth;   // deepest container nesting met while parsing
+    size_t tokens;       // tokens lexed
+    double lex_seconds;  // time spent in the lexer, two clock reads per token included
+    double load_seconds; // time spent in cson_load_xxx, minus lex_seconds it is the tree building
+} cson_stats_t;
+
+// cson_stats - read the counters of the calling thread
+// Return: counters since the start or the last cson_stats_reset, all zero
+//         without CSON_ENABLE_STATS
+CSONDEF cson_stats_t cson_stats(void);
+
+// cson_stats_reset - zero the counters of the calling thread
+CSONDEF void cson_stats_reset(void);
+
 #ifdef __cplusplus
 }
+
+// cson_field_kind_of - field kind of a member type, see CSON_FIELD_OF
+template <typename T> struct cson_field_kind_of;
+template <> struct cson_field_kind_of<bool> {
+    static constexpr cson_field_kind_t value = CSON_FIELD_BOOLEAN;
+};
+template <> struct cson_field_kind_of<int64_t> {
+    static constexpr cson_field_kind_t value = CSON_FIELD_INT64;
+};
+template <> struct cson_field_kind_of<double> {
+    static constexpr cson_field_kind_t value = CSON_FIELD_DOUBLE;
+};
+template <> struct cson_field_kind_of<char *> {
+    static constexpr cson_field_kind_t value = CSON_FIELD_STRING;
+};
+template <size_t N> struct cson_field_kind_of<char[N]> {
+    static constexpr cson_field_kind_t value = CSON_FIELD_CHARS;
+};
+
+// CSON_FIELD_OF - describe the member of a struct, the kind is deduced from its type
+// @type: struct type
+// @member: member name, also used as the json key
+#define CSON_FIELD_OF(type, member) CSON_FIELD(type, member, cson_field_kind_of<decltype(type::member)>::value)
 #endif
 
 #endif // CSON_H
 
 #ifdef CSON_IMPLEMENTATION
 
+#include <locale.h>
+#include <math.h>
+#include <errno.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if !defined(CSON_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define CSON__MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if !defined(CSON_NO_SIMD) && defined(__AVX2__)
+#define CSON__AVX2
+#include <immintrin.h>
+#elif !defined(CSON_NO_SIMD) && defined(__SSE2__)
+#define CSON__SSE2
+#include <emmintrin.h>
+#elif !defined(CSON_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define CSON__NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(CSON__AVX2) || defined(CSON__SSE2) || defined(CSON__NEON)
+#define CSON__SIMD
+#endif
+
+#if !defined(CSON_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define CSON__THREADS
+#include <pthread.h>
+#endif
+
 #define cson__fatal(fmt, ...)                                                 \
     do {                                                                      \
         fprintf(stderr, "%s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
         abort();                                                              \
     } while (0)
 
-CSONDEF void cson_append(cson_node_t *node, cson_node_t item) {
-    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
-        cson__fatal("node should be object or array type");
-    }
-    cson_nodes_t *da = &node->as.container;
-    if (da->len + 1 > da->cap) {
-        da->cap = da->cap < 16 ? 16 : 2*da->cap;
-        da->items = (cson_node_t *) realloc(da->items, sizeof(cson_node_t)*da->cap);
-        if (!da->items) cson__fatal("out of memory");
-    }
-    da->items[da->len++] = item;
-}
+typedef struct {
+    uint32_t hash;
+    uint32_t idx; // item index + 1, 0 if the slot is empty
+} cson__slot_t;
 
-// read_file - read the file content
-// @path: file path (should not be null)
-// Return: dynamically allocated buffer of file content
-static char *cson__read_file(const char *path) {
-    FILE *f = NULL;
-    char *buffer = NULL;
-    long size;
+// allocator used for every heap block of the library, define all three
+// before including the implementation to replace malloc, realloc and free,
+// CSON_FREE must accept NULL and free whatever the other two returned
+#ifndef CSON_MALLOC
+#define CSON_MALLOC(size) malloc(size)
+#define CSON_REALLOC(ptr, size) realloc(ptr, size)
+#define CSON_FREE(ptr) free(ptr)
+#endif
 
-    f = fopen(path, "r");
-    if (!f) goto fail;
+#if defined(CSON_ENABLE_STATS)
+#include <time.h>
 
-    fseek(f, 0, SEEK_END);
-    size = ftell(f);
-    rewind(f);
-    if (size <= 0) goto fail;
+#if defined(_MSC_VER)
+#define CSON__THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define CSON__THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define CSON__THREAD_LOCAL _Thread_local
+#else
+#define CSON__THREAD_LOCAL
+#endif
 
-    buffer = (char *) malloc(size);
-    if (!buffer) goto fail;
-    if (fread(buffer, size, 1, f) != 1) goto fail;
+static CSON__THREAD_LOCAL cson_stats_t cson__stats;
 
-    fclose(f);
-    return buffer;
-fail:
-    if (f) fclose(f);
-    if (buffer) free(buffer);
-    return NULL;
+// cson__now - read the clock used by the statistics
+// Return: seconds from an arbitrary start
+static double cson__now(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1e-9*(double) ts.tv_nsec;
+#else
+    return (double) clock()/CLOCKS_PER_SEC;
+#endif
 }
 
-// cson__make_punc - make a punctuation token
-// @lex: pointer to lexer
-// @kind: token type
-// Return: a punctuation (length = 1) token
-static cson_token_t cson__make_punc(cson_lexer_t *lex, cson_token_kind_t kind) {
-    return (cson_token_t) {
-        .kind = kind,
-        .start = lex->current++,
-        .len = 1
-    };
+#define CSON__STAT_ADD(field, n) ((void) (cson__stats.field += (n)))
+#define CSON__STAT_CLOCK(var) double var = cson__now()
+#define CSON__STAT_SINCE(var) (cson__now() - (var))
+#define CSON__STAT_PEAK(depth)                                                \
+    ((void) ((depth) > cson__stats.peak_depth && (cson__stats.peak_depth = (depth))))
+#else
+#define CSON__STAT_ADD(field, n) ((void) 0)
+#define CSON__STAT_CLOCK(var)
+#define CSON__STAT_PEAK(depth) ((void) 0)
+#endif
+
+CSONDEF cson_stats_t cson_stats(void) {
+#if defined(CSON_ENABLE_STATS)
+    return cson__stats;
+#else
+    cson_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+#endif
 }
 
-// cson__make_string - make string token
-// @lex: pointer to lexer
-// Note: assume the string has the balanced '"'
-// Return: a string (exclude '"') token
-static cson_token_t cson__make_string(cson_lexer_t *lex) {
-    lex->current++; // skip open '"'
-    while (*lex->current != '"') lex->current++;
-    lex->current++; // skip closed '"'
-    return (cson_token_t) {
-        .kind = CSON_TK_STRING,
-        .start = lex->start + 1,
-        .len = (size_t) (lex->current - lex->start - 2)
-    };
+CSONDEF void cson_stats_reset(void) {
+#if defined(CSON_ENABLE_STATS)
+    memset(&cson__stats, 0, sizeof(cson__stats));
+#endif
 }
 
-// cson__make_number - make number token
-// @lex: pointer to lexer
-// Return: a number (include '.') token
-static cson_token_t cson__make_number(cson_lexer_t *lex) {
-    while (isdigit(*lex->current)) lex->current++;
-    if (*lex->current != '.') goto exit;
-    lex->current++; // skip '.'
-    while (isdigit(*lex->current)) lex->current++;
-exit:
-    return (cson_token_t) {
-        .kind = CSON_TK_NUMBER,
-        .start = lex->start,
-        .len = (size_t) (lex->current - lex->start)
-    };
+// cson__malloc - allocate through CSON_MALLOC
+// @size: allocation size
+// Note: abort if out of memory
+// Return: heap block
+static void *cson__malloc(size_t size) {
+    void *p = CSON_MALLOC(size);
+    if (!p) cson__fatal("out of memory");
+    CSON__STAT_ADD(allocations, 1);
+    CSON__STAT_ADD(bytes, size);
+    return p;
 }
 
-// cson__make_literal - make literal token
-// @lex: pointer to lexer
-// Note: only support null/true/false
-// Return: a literal token
-static cson_token_t cson__make_literal(cson_lexer_t *lex) {
-    cson_token_t token;
-    switch (*lex->start) {
-    case 'f': token.kind = CSON_TK_FALSE; lex->current += 5; break;
-    case 'n': token.kind = CSON_TK_NULL;  lex->current += 4; break;
-    case 't': token.kind = CSON_TK_TRUE;  lex->current += 4; break;
+// cson__realloc - resize through CSON_REALLOC
+// @ptr: heap block (Nullable)
+// @size: new size
+// Note: abort if out of memory
+// Return: resized heap block
+static void *cson__realloc(void *ptr, size_t size) {
+    void *p = CSON_REALLOC(ptr, size);
+    if (!p) cson__fatal("out of memory");
+    CSON__STAT_ADD(allocations, 1);
+    CSON__STAT_ADD(bytes, size);
+    return p;
+}
+
+// cson__calloc - allocate zeroed memory through CSON_MALLOC
+// @n: element count
+// @size: element size
+// Return: zeroed heap block
+static void *cson__calloc(size_t n, size_t size) {
+    if (size && n > SIZE_MAX/size) cson__fatal("out of memory");
+    void *p = cson__malloc(n*size);
+    memset(p, 0, n*size);
+    return p;
+}
+
+// cson__free - release through CSON_FREE
+// @ptr: heap block (Nullable)
+static void cson__free(void *ptr) {
+    if (ptr) CSON_FREE(ptr);
+}
+
+
+// cson__hash - FNV-1a hash of a key
+// @s: key text
+// @len: key length
+// Return: 32-bit hash
+static uint32_t cson__hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
     }
-    token.start = lex->start;
-    token.len = lex->current - lex->start;
-    return token;
+    return h;
 }
 
-// cson__make_eof - make a eof token
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define cson__atomic_load_ptr(p) (*(void *volatile *) (p))
+#define cson__atomic_cas_ptr(p, expected, desired) \
+    (_InterlockedCompareExchangePointer((void *volatile *) (p), (desired), (expected)) == (expected))
+#define cson__atomic_load_size(p) (*(volatile size_t *) (p))
+#define cson__atomic_inc(p) ((size_t) _InterlockedIncrement64((volatile long long *) (p)))
+#define cson__atomic_add(p, v) ((size_t) _InterlockedExchangeAdd64((volatile long long *) (p), (long long) (v)) + (v))
+#define cson__atomic_sub(p, v) ((size_t) _InterlockedExchangeAdd64((volatile long long *) (p), -(long long) (v)) - (v))
+#define cson__atomic_load_seq(p) ((size_t) _InterlockedOr64((volatile long long *) (p), 0))
+#define cson__atomic_xchg_ptr(p, v) _InterlockedExchangePointer((void *volatile *) (p), (v))
+#else
+#define cson__atomic_load_ptr(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define cson__atomic_cas_ptr(p, expected, desired) \
+    __atomic_compare_exchange_n((p), &(expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define cson__atomic_load_size(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define cson__atomic_inc(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#define cson__atomic_add(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define cson__atomic_sub(p, v) __atomic_sub_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define cson__atomic_load_seq(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define cson__atomic_xchg_ptr(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#endif
+
+#if defined(CSON__THREADS)
+#include <sched.h>
+#define cson__yield() sched_yield()
+#else
+#define cson__yield() ((void) 0)
+#endif
+
+// header stored in front of every interned key
+typedef struct {
+    uint32_t hash;
+    uint32_t len;
+} cson__key_header_t;
+
+// cson__key_hash - get the hash of a key
+// @key: key text
+// @interned: key is owned by a cson_keytab_t
+// Return: same value as cson__hash, read from the header if interned
+static uint32_t cson__key_hash(const char *key, bool interned) {
+    if (interned) return ((const cson__key_header_t *) key - 1)->hash;
+    return cson__hash(key, strlen(key));
+}
+
+// cson__keytab_intern - intern a key of known length
+// @keys: table
+// @s: key text (not NUL-terminated)
+// @len: key length
+// Note: a new key is published with one compare-and-swap on an empty slot,
+//       a thread losing the race compares against the winner instead
+// Return: canonical key, NULL if the table is full
+static char *cson__keytab_intern(cson_keytab_t *keys, const char *s, size_t len) {
+    uint32_t hash = cson__hash(s, len);
+    size_t mask = keys->cap - 1;
+    cson__key_header_t *mine = NULL;
+
+    for (size_t n = 0, i = hash & mask; n <= mask; n++, i = (i + 1) & mask) {
+        char *cur = (char *) cson__atomic_load_ptr(&keys->slots[i]);
+        if (!cur) {
+            if (!mine) {
+                if (cson__atomic_load_size(&keys->count) >= keys->cap - keys->cap/4) return NULL;
+                mine = (cson__key_header_t *) cson__malloc(sizeof(cson__key_header_t) + len + 1);
+                mine->hash = hash;
+                mine->len = (uint32_t) len;
+                memcpy(mine + 1, s, len);
+                ((char *) (mine + 1))[len] = '\0';
+            }
+            char *expected = NULL;
+            if (cson__atomic_cas_ptr(&keys->slots[i], expected, (char *) (mine + 1))) {
+                cson__atomic_inc(&keys->count);
+                return (char *) (mine + 1);
+            }
+            cur = (char *) cson__atomic_load_ptr(&keys->slots[i]);
+        }
+        const cson__key_header_t *header = (const cson__key_header_t *) cur - 1;
+        if (header->hash == hash && header->len == len && memcmp(cur, s, len) == 0) {
+            cson__free(mine);
+            return cur;
+        }
+    }
+    cson__free(mine);
+    return NULL;
+}
+
+CSONDEF void cson_keytab_init(cson_keytab_t *keys, size_t capacity) {
+    size_t cap = 16;
+    while (cap < 2*capacity) cap <<= 1;
+    keys->slots = (char **) cson__calloc(cap, sizeof(char *));
+    keys->cap = cap;
+    keys->count = 0;
+}
+
+CSONDEF void cson_keytab_free(cson_keytab_t *keys) {
+    if (!keys) return;
+    for (size_t i = 0; i < keys->cap; i++) {
+        if (keys->slots[i]) cson__free((cson__key_header_t *) keys->slots[i] - 1);
+    }
+    cson__free(keys->slots);
+    keys->slots = NULL;
+    keys->cap = 0;
+    keys->count = 0;
+}
+
+CSONDEF const char *cson_keytab_intern(cson_keytab_t *keys, const char *key) {
+    return cson__keytab_intern(keys, key, strlen(key));
+}
+
+static void cson__materialize(cson_node_t *node);
+
+CSONDEF void cson_intern_keys(cson_node_t *root, cson_keytab_t *keys) {
+    if (root->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (root->key && !(root->flags & CSON_FLAG_KEY_INTERNED)) {
+        char *key = cson__keytab_intern(keys, root->key, strlen(root->key));
+        if (key) {
+            if (!(root->flags & (CSON_FLAG_ARENA | CSON_FLAG_BORROWED))) cson__free(root->key);
+            root->key = key;
+            root->flags |= CSON_FLAG_KEY_INTERNED;
+        }
+    }
+    if (root->kind == CSON_OBJECT || root->kind == CSON_ARRAY) {
+        if (root->flags & CSON_FLAG_LAZY) cson__materialize(root);
+        for (size_t i = 0; i < root->as.container.len; i++) {
+            cson_intern_keys(&root->as.container.items[i], keys);
+        }
+    }
+}
+
+// cson__grow - next capacity of a node array
+// @cap: current capacity
+// @min: first capacity
+// Note: abort once a container would pass the 32-bit element count
+// Return: doubled capacity
+static uint32_t cson__grow(uint32_t cap, uint32_t min) {
+    if (cap < min) return min;
+    if (cap > UINT32_MAX/2) {
+        if (cap == UINT32_MAX) cson__fatal("container too large");
+        return UINT32_MAX;
+    }
+    return 2*cap;
+}
+
+// cson__index_slots - slot count of an object index
+// @cap: object capacity
+// Return: power of two, at least twice the capacity
+static size_t cson__index_slots(size_t cap) {
+    size_t n = 16;
+    while (n < 2*cap) n <<= 1;
+    return n;
+}
+
+// cson__items_size - byte size of a container allocation
+// @cap: container capacity
+// @indexed: reserve the hash index behind the items
+// Return: allocation size
+static size_t cson__items_size(size_t cap, bool indexed) {
+    size_t size = sizeof(cson_node_t)*cap;
+    if (indexed) size += sizeof(cson__slot_t)*cson__index_slots(cap);
+    return size;
+}
+
+// cson__index_of - get the hash index of an object
+// @da: items of an object with CSON_FLAG_INDEXED
+// Note: the slots live in the same allocation, right after items[cap]
+// Return: slot array
+static cson__slot_t *cson__index_of(const cson_nodes_t *da) {
+    return (cson__slot_t *) (da->items + da->cap);
+}
+
+// cson__index_insert - add an item to the hash index
+// @da: items of an indexed object
+// @idx: item index
+static void cson__index_insert(cson_nodes_t *da, size_t idx) {
+    const char *key = da->items[idx].key;
+    if (!key) return;
+    cson__slot_t *slots = cson__index_of(da);
+    size_t mask = cson__index_slots(da->cap) - 1;
+    uint32_t hash = cson__key_hash(key, da->items[idx].flags & CSON_FLAG_KEY_INTERNED);
+    size_t i = hash & mask;
+    while (slots[i].idx) i = (i + 1) & mask;
+    slots[i].hash = hash;
+    slots[i].idx = (uint32_t) (idx + 1);
+}
+
+// cson__index_build - rebuild the hash index from the items
+// @da: items of an indexed object
+static void cson__index_build(cson_nodes_t *da) {
+    memset(cson__index_of(da), 0, sizeof(cson__slot_t)*cson__index_slots(da->cap));
+    for (size_t i = 0; i < da->len; i++) cson__index_insert(da, i);
+}
+
+// cson__index_find - find the slot of a key
+// @da: items of an indexed object
+// @key: member key
+// @hash: hash of key
+// Return: slot position, or -1 if not exists
+static long cson__index_find(const cson_nodes_t *da, const char *key, uint32_t hash) {
+    const cson__slot_t *slots = cson__index_of(da);
+    size_t mask = cson__index_slots(da->cap) - 1;
+    for (size_t i = hash & mask; slots[i].idx; i = (i + 1) & mask) {
+        if (slots[i].hash != hash) continue;
+        const char *other = da->items[slots[i].idx - 1].key;
+        if (other == key || strcmp(other, key) == 0) return (long) i;
+    }
+    return -1;
+}
+
+// cson__index_erase - remove a slot with backward shift deletion
+// @da: items of an indexed object
+// @pos: slot position
+// Note: keeps every probe chain contiguous, so no tombstones are needed
+static void cson__index_erase(cson_nodes_t *da, size_t pos) {
+    cson__slot_t *slots = cson__index_of(da);
+    size_t mask = cson__index_slots(da->cap) - 1;
+    size_t hole = pos;
+    for (size_t i = (pos + 1) & mask; slots[i].idx; i = (i + 1) & mask) {
+        size_t home = slots[i].hash & mask;
+        // move the entry back unless its home lies in (hole, i]
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].hash = 0;
+    slots[hole].idx = 0;
+}
+
+// cson__index_remove - drop the slot of an item that is about to be removed
+// @da: items of an indexed object, item idx still in place
+// @idx: item index
+// Note: the items behind idx move down by one, so their slots are renumbered
+static void cson__index_remove(cson_nodes_t *da, size_t idx) {
+    cson__slot_t *slots = cson__index_of(da);
+    size_t mask = cson__index_slots(da->cap) - 1;
+    const cson_node_t *item = &da->items[idx];
+    if (item->key) {
+        uint32_t hash = cson__key_hash(item->key, item->flags & CSON_FLAG_KEY_INTERNED);
+        for (size_t i = hash & mask; slots[i].idx; i = (i + 1) & mask) {
+            if (slots[i].idx == idx + 1) {
+                cson__index_erase(da, i);
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i <= mask; i++) {
+        if (slots[i].idx > idx + 1) slots[i].idx--;
+    }
+}
+
+// cson__container_check - check that items can be added to a node
+// @node: target node
+static void cson__container_check(const cson_node_t *node) {
+    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
+        cson__fatal("node should be object or array type");
+    }
+    if (node->flags & CSON_FLAG_ARENA) cson__fatal("node belongs to an arena document");
+    if (node->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+}
+
+// cson__container_reserve - make the allocation of a container hold need items
+// @node: object or array outside an arena
+// @need: item count
+// Note: an object reaching CSON_INDEX_THRESHOLD gets its hash index, which
+//       lives behind the items and so is rebuilt whenever they move
+static void cson__container_reserve(cson_node_t *node, size_t need) {
+    cson_nodes_t *da = &node->as.container;
+    bool indexed = node->kind == CSON_OBJECT &&
+                   ((node->flags & CSON_FLAG_INDEXED) || need >= CSON_INDEX_THRESHOLD);
+    if (need <= da->cap && (!indexed || (node->flags & CSON_FLAG_INDEXED))) return;
+    if (need > UINT32_MAX) cson__fatal("container too large");
+    uint32_t cap = da->cap;
+    while (cap < need) cap = cson__grow(cap, 16);
+    da->items = (cson_node_t *) cson__realloc(da->items, cson__items_size(cap, indexed));
+    da->cap = cap;
+    if (indexed) {
+        node->flags |= CSON_FLAG_INDEXED;
+        cson__index_build(da);
+    }
+}
+
+CSONDEF void cson_append(cson_node_t *node, cson_node_t item) {
+    cson__container_check(node);
+    cson_nodes_t *da = &node->as.container;
+    cson__container_reserve(node, (size_t) da->len + 1);
+    da->items[da->len++] = item;
+    if (node->flags & CSON_FLAG_INDEXED) cson__index_insert(da, da->len - 1);
+}
+
+static char *cson__strndup(const char *s, size_t len);
+
+CSONDEF cson_node_t *cson_append_new(cson_node_t *node, cson_node_kind_t kind, const char *key) {
+    cson__container_check(node);
+    cson_nodes_t *da = &node->as.container;
+    cson__container_reserve(node, (size_t) da->len + 1);
+    cson_node_t *item = &da->items[da->len++];
+    memset(item, 0, sizeof(*item));
+    item->kind = kind;
+    item->key = key ? cson__strndup(key, strlen(key)) : NULL;
+    CSON__STAT_ADD(nodes, 1);
+    if (node->flags & CSON_FLAG_INDEXED) cson__index_insert(da, da->len - 1);
+    return item;
+}
+
+CSONDEF void cson_append_many(cson_node_t *node, const cson_node_t *items, size_t n) {
+    cson__container_check(node);
+    if (n == 0) return;
+    cson_nodes_t *da = &node->as.container;
+    cson__container_reserve(node, (size_t) da->len + n);
+    memcpy(da->items + da->len, items, sizeof(cson_node_t)*n);
+    da->len += (uint32_t) n;
+    if (node->flags & CSON_FLAG_INDEXED) {
+        for (size_t i = da->len - n; i < da->len; i++) cson__index_insert(da, i);
+    }
+}
+
+CSONDEF void cson_reserve(cson_node_t *node, size_t cap) {
+    cson__container_check(node);
+    cson__container_reserve(node, cap);
+}
+
+// contents of an input file, either mapped or read into memory
+typedef struct {
+    char *data;
+    size_t len;
+    bool mapped;
+} cson__file_t;
+
+// cson__file_open - get the file content
+// @file: output file content
+// @path: file path (should not be null)
+// @writable: the content will be modified (never mapped)
+// Note: files of at least CSON_MMAP_THRESHOLD bytes are mapped read-only,
+//       which shares their pages with other processes and avoids a copy,
+//       other files are read into a NUL-terminated heap buffer
+// Return: false if the file is empty or cannot be read
+static bool cson__file_open(cson__file_t *file, const char *path, bool writable) {
+    memset(file, 0, sizeof(*file));
+
+#if defined(CSON__MMAP)
+    if (!writable) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        if ((size_t) st.st_size >= CSON_MMAP_THRESHOLD) {
+            void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) return false;
+#if defined(MADV_SEQUENTIAL)
+            madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+#endif
+            file->data = (char *) data;
+            file->len = (size_t) st.st_size;
+            file->mapped = true;
+            return true;
+        }
+        close(fd);
+    }
+#else
+    (void) writable;
+#endif
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *buffer = size > 0 ? (char *) cson__malloc((size_t) size + 1) : NULL;
+    if (!buffer || fread(buffer, (size_t) size, 1, f) != 1) {
+        fclose(f);
+        cson__free(buffer);
+        return false;
+    }
+    fclose(f);
+    buffer[size] = '\0';
+    file->data = buffer;
+    file->len = (size_t) size;
+    return true;
+}
+
+// cson__file_close - release the file content
+// @file: file content
+static void cson__file_close(cson__file_t *file) {
+#if defined(CSON__MMAP)
+    if (file->mapped) {
+        munmap(file->data, file->len);
+        file->data = NULL;
+        return;
+    }
+#endif
+    cson__free(file->data);
+    file->data = NULL;
+}
+
+#define cson__is_digit(ch) ((unsigned char) ((ch) - '0') < 10)
+#define cson__is_space(ch) ((ch) == ' ' || (ch) == '\n' || (ch) == '\r' || (ch) == '\t')
+
+#if defined(CSON__SIMD)
+// cson__ctz - count trailing zero bits
+// @x: non-zero mask
+// Return: index of the lowest set bit
+static unsigned cson__ctz(unsigned long long x) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (unsigned) idx;
+#else
+    return (unsigned) __builtin_ctzll(x);
+#endif
+}
+#endif
+
+#if defined(CSON__NEON)
+// cson__neon_mask - compress a byte compare result into a bit mask
+// @eq: compare result (each byte 0x00 or 0xff)
+// Return: 4 bits per byte, so a byte index is ctz(mask)/4
+static unsigned long long cson__neon_mask(uint8x16_t eq) {
+    uint8x8_t res = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(res), 0);
+}
+#endif
+
+// cson__skip_space - skip a whitespace run
+// @p: current position
+// @end: end of input
+// Note: long runs (indentation) are skipped a vector at a time
+// Return: first non-whitespace position or end
+static const char *cson__skip_space(const char *p, const char *end) {
+    if (p >= end || !cson__is_space(*p)) return p;
+#if defined(CSON__AVX2)
+    const __m256i sp = _mm256_set1_epi8(' '), nl = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r'), tab = _mm256_set1_epi8('\t');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, tab)));
+        unsigned mask = ~(unsigned) _mm256_movemask_epi8(ws);
+        if (mask) return p + cson__ctz(mask);
+        p += 32;
+    }
+#elif defined(CSON__SSE2)
+    const __m128i sp = _mm_set1_epi8(' '), nl = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r'), tab = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+        unsigned mask = ~(unsigned) _mm_movemask_epi8(ws) & 0xffff;
+        if (mask) return p + cson__ctz(mask);
+        p += 16;
+    }
+#elif defined(CSON__NEON)
+    const uint8x16_t sp = vdupq_n_u8(' '), nl = vdupq_n_u8('\n');
+    const uint8x16_t cr = vdupq_n_u8('\r'), tab = vdupq_n_u8('\t');
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *) p);
+        uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, nl)),
+                                 vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, tab)));
+        unsigned long long mask = ~cson__neon_mask(ws);
+        if (mask) return p + cson__ctz(mask)/4;
+        p += 16;
+    }
+#endif
+    while (p < end && cson__is_space(*p)) p++;
+    return p;
+}
+
+// cson__scan_string - find the closing '"' of a string body
+// @p: first byte after the opening '"'
+// @end: end of input
+// Note: a vector is searched for '"' and '\\' at once, escaped bytes are skipped
+// Return: pointer to closing '"', or end if the string is unterminated
+static const char *cson__scan_string(const char *p, const char *end) {
+    while (1) {
+#if defined(CSON__AVX2)
+        const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+        while (end - p >= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) p);
+            unsigned mask = (unsigned) _mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash)));
+            if (mask) { p += cson__ctz(mask); goto found; }
+            p += 32;
+        }
+#elif defined(CSON__SSE2)
+        const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\');
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            unsigned mask = (unsigned) _mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)));
+            if (mask) { p += cson__ctz(mask); goto found; }
+            p += 16;
+        }
+#elif defined(CSON__NEON)
+        const uint8x16_t quote = vdupq_n_u8('"'), bslash = vdupq_n_u8('\\');
+        while (end - p >= 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p);
+            unsigned long long mask = cson__neon_mask(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)));
+            if (mask) { p += cson__ctz(mask)/4; goto found; }
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\') p++;
+#if defined(CSON__SIMD)
+    found:
+#endif
+        if (p >= end || *p == '"') return p;
+        if (end - p < 2) return end;
+        p += 2; // skip escape sequence start
+    }
+}
+
+// cson__hex_digit - value of a hex digit
+// @c: byte
+// Return: 0 to 15, or -1 if c is no hex digit
+static int cson__hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// cson__hex4 - read the four hex digits of a '\u' escape
+// @s: first digit
+// @end: end of input
+// @cp: output code unit
+// Return: 1 on success, 0 on a bad digit, -1 if the input ends first
+static int cson__hex4(const char *s, const char *end, uint32_t *cp) {
+    *cp = 0;
+    for (int i = 0; i < 4; i++) {
+        if (s + i >= end) return -1;
+        int d = cson__hex_digit(s[i]);
+        if (d < 0) return 0;
+        *cp = *cp << 4 | (uint32_t) d;
+    }
+    return 1;
+}
+
+// cson__hex4_checked - read four hex digits already checked
+// @s: first digit
+// Note: bit 6 is set in letters only, whichever case
+// Return: code unit
+static uint32_t cson__hex4_checked(const char *s) {
+    uint32_t cp = 0;
+    for (int i = 0; i < 4; i++) {
+        unsigned c = (unsigned char) s[i];
+        cp = cp << 4 | ((c & 0xf) + 9*(c >> 6));
+    }
+    return cp;
+}
+
+// cson__check_escape - check one escape sequence
+// @p: the '\\'
+// @end: end of input
+// Note: a high surrogate must be followed by a '\u' low surrogate, lone
+//       surrogates have no utf-8 form and are rejected
+// Return: pointer behind the sequence, NULL if it is invalid, or end if the
+//         input ends inside it
+static const char *cson__check_escape(const char *p, const char *end) {
+    if (end - p < 2) return end;
+    switch (p[1]) {
+    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': return p + 2;
+    case 'u': break;
+    default: return NULL;
+    }
+    uint32_t cp, lo;
+    int ok = cson__hex4(p + 2, end, &cp);
+    if (ok <= 0) return ok ? end : NULL;
+    if (cp < 0xd800 || cp > 0xdfff) return p + 6;
+    if (cp > 0xdbff) return NULL;
+    p += 6;
+    if (p >= end || (p[0] == '\\' && end - p < 2)) return end;
+    if (p[0] != '\\' || p[1] != 'u') return NULL;
+    ok = cson__hex4(p + 2, end, &lo);
+    if (ok <= 0) return ok ? end : NULL;
+    return lo >= 0xdc00 && lo <= 0xdfff ? p + 6 : NULL;
+}
+
+// cson__check_utf8 - check one utf-8 sequence
+// @p: lead byte, above 0x7f
+// @end: end of input
+// Note: overlong forms, surrogates and code points above U+10FFFF are rejected
+// Return: pointer behind the sequence, NULL if it is invalid, or end if the
+//         input ends inside it
+static const char *cson__check_utf8(const char *p, const char *end) {
+    const unsigned char *s = (const unsigned char *) p;
+    size_t len = s[0] < 0xc2 ? 0 : s[0] < 0xe0 ? 2 : s[0] < 0xf0 ? 3 : s[0] < 0xf5 ? 4 : 0;
+    if (len == 0) return NULL;
+    unsigned char lo = 0x80, hi = 0xbf;
+    if (s[0] == 0xe0) lo = 0xa0;
+    else if (s[0] == 0xed) hi = 0x9f;
+    else if (s[0] == 0xf0) lo = 0x90;
+    else if (s[0] == 0xf4) hi = 0x8f;
+    for (size_t i = 1; i < len; i++) {
+        if (p + i >= end) return end;
+        if (s[i] < lo || s[i] > hi) return NULL;
+        lo = 0x80;
+        hi = 0xbf;
+    }
+    return p + len;
+}
+
+// cson__utf8_open - check if the bytes before e leave a utf-8 sequence open
+// @e: end of a checked vector
+#define cson__utf8_open(e) ((unsigned char) (e)[-1] >= 0xc0 || (unsigned char) (e)[-2] >= 0xe0 || \
+                            (unsigned char) (e)[-3] >= 0xf0)
+
+// cson__utf8_errors - flag the bytes of a vector that break utf-8
+// @v: string bytes
+// @prev: previous vector of the same string, or zeros
+// Note: a byte must be a continuation exactly when one of the three bytes
+//       before it leads a sequence that long, and the byte after e0, ed, f0
+//       or f4 has a narrower range; this needs the previous vector because
+//       a sequence may start there; continuation bytes are -128 to -65 as
+//       signed bytes, so the ranges are signed compares
+// Return: 0xff in every offending byte, zeros elsewhere
+#if defined(CSON__AVX2)
+static __m256i cson__utf8_errors(__m256i v, __m256i prev) {
+#define CSON__SET(c) _mm256_set1_epi8((char) (c))
+    __m256i carry = _mm256_permute2x128_si256(prev, v, 0x21);
+    __m256i p1 = _mm256_alignr_epi8(v, carry, 15), p2 = _mm256_alignr_epi8(v, carry, 14);
+    __m256i p3 = _mm256_alignr_epi8(v, carry, 13);
+    __m256i need = _mm256_or_si256(_mm256_subs_epu8(p1, CSON__SET(0xbf)),
+                                   _mm256_or_si256(_mm256_subs_epu8(p2, CSON__SET(0xdf)),
+                                                   _mm256_subs_epu8(p3, CSON__SET(0xef))));
+    __m256i other = _mm256_cmpgt_epi8(v, CSON__SET(0xbf)); // not a continuation
+    __m256i err = _mm256_xor_si256(_mm256_cmpeq_epi8(need, _mm256_setzero_si256()), other);
+    err = _mm256_or_si256(err, _mm256_cmpeq_epi8(_mm256_and_si256(v, CSON__SET(0xfe)), CSON__SET(0xc0)));
+    err = _mm256_or_si256(err, _mm256_and_si256(_mm256_cmpgt_epi8(v, CSON__SET(0xf4)),
+                                                _mm256_cmpgt_epi8(_mm256_setzero_si256(), v)));
+    __m256i lead3 = _mm256_cmpeq_epi8(_mm256_subs_epu8(p1, CSON__SET(0xdf)), _mm256_setzero_si256());
+    if ((unsigned) _mm256_movemask_epi8(lead3) == 0xffffffffu) return err; // none after e0 to ff
+    __m256i e0 = _mm256_and_si256(_mm256_cmpeq_epi8(p1, CSON__SET(0xe0)), _mm256_cmpgt_epi8(CSON__SET(0xa0), v));
+    __m256i ed = _mm256_and_si256(_mm256_cmpeq_epi8(p1, CSON__SET(0xed)), _mm256_cmpgt_epi8(v, CSON__SET(0x9f)));
+    __m256i f0 = _mm256_and_si256(_mm256_cmpeq_epi8(p1, CSON__SET(0xf0)), _mm256_cmpgt_epi8(CSON__SET(0x90), v));
+    __m256i f4 = _mm256_and_si256(_mm256_cmpeq_epi8(p1, CSON__SET(0xf4)), _mm256_cmpgt_epi8(v, CSON__SET(0x8f)));
+    return _mm256_or_si256(err, _mm256_or_si256(_mm256_or_si256(e0, ed), _mm256_or_si256(f0, f4)));
+#undef CSON__SET
+}
+#elif defined(CSON__SSE2)
+static __m128i cson__utf8_errors(__m128i v, __m128i prev) {
+#define CSON__SET(c) _mm_set1_epi8((char) (c))
+    __m128i p1 = _mm_or_si128(_mm_slli_si128(v, 1), _mm_srli_si128(prev, 15));
+    __m128i p2 = _mm_or_si128(_mm_slli_si128(v, 2), _mm_srli_si128(prev, 14));
+    __m128i p3 = _mm_or_si128(_mm_slli_si128(v, 3), _mm_srli_si128(prev, 13));
+    __m128i need = _mm_or_si128(_mm_subs_epu8(p1, CSON__SET(0xbf)),
+                                _mm_or_si128(_mm_subs_epu8(p2, CSON__SET(0xdf)),
+                                             _mm_subs_epu8(p3, CSON__SET(0xef))));
+    __m128i other = _mm_cmpgt_epi8(v, CSON__SET(0xbf)); // not a continuation
+    __m128i err = _mm_xor_si128(_mm_cmpeq_epi8(need, _mm_setzero_si128()), other);
+    err = _mm_or_si128(err, _mm_cmpeq_epi8(_mm_and_si128(v, CSON__SET(0xfe)), CSON__SET(0xc0)));
+    err = _mm_or_si128(err, _mm_and_si128(_mm_cmpgt_epi8(v, CSON__SET(0xf4)),
+                                          _mm_cmplt_epi8(v, _mm_setzero_si128())));
+    __m128i lead3 = _mm_cmpeq_epi8(_mm_subs_epu8(p1, CSON__SET(0xdf)), _mm_setzero_si128());
+    if (_mm_movemask_epi8(lead3) == 0xffff) return err; // none after e0 to ff
+    __m128i e0 = _mm_and_si128(_mm_cmpeq_epi8(p1, CSON__SET(0xe0)), _mm_cmplt_epi8(v, CSON__SET(0xa0)));
+    __m128i ed = _mm_and_si128(_mm_cmpeq_epi8(p1, CSON__SET(0xed)), _mm_cmpgt_epi8(v, CSON__SET(0x9f)));
+    __m128i f0 = _mm_and_si128(_mm_cmpeq_epi8(p1, CSON__SET(0xf0)), _mm_cmplt_epi8(v, CSON__SET(0x90)));
+    __m128i f4 = _mm_and_si128(_mm_cmpeq_epi8(p1, CSON__SET(0xf4)), _mm_cmpgt_epi8(v, CSON__SET(0x8f)));
+    return _mm_or_si128(err, _mm_or_si128(_mm_or_si128(e0, ed), _mm_or_si128(f0, f4)));
+#undef CSON__SET
+}
+#elif defined(CSON__NEON)
+static uint8x16_t cson__utf8_errors(uint8x16_t v, uint8x16_t prev) {
+    uint8x16_t p1 = vextq_u8(prev, v, 15), p2 = vextq_u8(prev, v, 14), p3 = vextq_u8(prev, v, 13);
+    uint8x16_t need = vorrq_u8(vcgeq_u8(p1, vdupq_n_u8(0xc0)),
+                               vorrq_u8(vcgeq_u8(p2, vdupq_n_u8(0xe0)), vcgeq_u8(p3, vdupq_n_u8(0xf0))));
+    uint8x16_t cont = vceqq_u8(vandq_u8(v, vdupq_n_u8(0xc0)), vdupq_n_u8(0x80));
+    uint8x16_t err = veorq_u8(need, cont);
+    err = vorrq_u8(err, vorrq_u8(vceqq_u8(vandq_u8(v, vdupq_n_u8(0xfe)), vdupq_n_u8(0xc0)),
+                                 vcgeq_u8(v, vdupq_n_u8(0xf5))));
+    if (!cson__neon_mask(vcgeq_u8(p1, vdupq_n_u8(0xe0)))) return err; // none after e0 to ff
+    uint8x16_t e0 = vandq_u8(vceqq_u8(p1, vdupq_n_u8(0xe0)), vcltq_u8(v, vdupq_n_u8(0xa0)));
+    uint8x16_t ed = vandq_u8(vceqq_u8(p1, vdupq_n_u8(0xed)), vcgeq_u8(v, vdupq_n_u8(0xa0)));
+    uint8x16_t f0 = vandq_u8(vceqq_u8(p1, vdupq_n_u8(0xf0)), vcltq_u8(v, vdupq_n_u8(0x90)));
+    uint8x16_t f4 = vandq_u8(vceqq_u8(p1, vdupq_n_u8(0xf4)), vcgeq_u8(v, vdupq_n_u8(0x90)));
+    return vorrq_u8(err, vorrq_u8(vorrq_u8(e0, ed), vorrq_u8(f0, f4)));
+}
+#endif
+
+// cson__check_string - find the closing '"' of a string body and check it
+// @p: first byte after the opening '"'
+// @end: end of input
+// @escaped: set to true if the body holds an escape sequence
+// @error: output error code when the body is invalid
+// Note: a vector is searched for '"', '\\' and control bytes, and one with
+//       bytes above 0x7f is checked as utf-8 in the same pass, so only escapes
+//       go byte by byte; a vector that fails the utf-8 check is checked again
+//       from its first sequence one byte at a time, which finds the error
+// Return: pointer to closing '"', end if the string is unterminated, or the
+//         offending byte with error set
+static const char *cson__check_string(const char *p, const char *end, bool *escaped,
+                                      cson_error_code_t *error) {
+#if defined(CSON__SIMD)
+    const char *begin = p;
+#endif
+    while (1) {
+#if defined(CSON__AVX2)
+        const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+        const __m256i ctrl = _mm256_set1_epi8(0x1f);
+        __m256i prev = _mm256_setzero_si256();
+        bool open = false;
+        while (end - p >= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) p);
+            __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v));
+            unsigned stop = (unsigned) _mm256_movemask_epi8(hit), high = (unsigned) _mm256_movemask_epi8(v);
+            if (!(high | open)) {
+                if (stop) { p += cson__ctz(stop); goto found; }
+                p += 32;
+                continue;
+            }
+            unsigned long long bad = (unsigned) _mm256_movemask_epi8(cson__utf8_errors(v, prev));
+            if (stop) bad &= (2ull << cson__ctz(stop)) - 1;
+            if (bad) goto slow;
+            if (stop) { p += cson__ctz(stop); goto found; }
+            prev = v;
+            p += 32;
+            open = cson__utf8_open(p);
+        }
+#elif defined(CSON__SSE2)
+        const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1f);
+        __m128i prev = _mm_setzero_si128();
+        bool open = false;
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+            unsigned stop = (unsigned) _mm_movemask_epi8(hit), high = (unsigned) _mm_movemask_epi8(v);
+            if (!(high | open)) {
+                if (stop) { p += cson__ctz(stop); goto found; }
+                p += 16;
+                continue;
+            }
+            unsigned bad = (unsigned) _mm_movemask_epi8(cson__utf8_errors(v, prev));
+            if (stop) bad &= (2u << cson__ctz(stop)) - 1;
+            if (bad) goto slow;
+            if (stop) { p += cson__ctz(stop); goto found; }
+            prev = v;
+            p += 16;
+            open = cson__utf8_open(p);
+        }
+#elif defined(CSON__NEON)
+        const uint8x16_t quote = vdupq_n_u8('"'), bslash = vdupq_n_u8('\\'), ctrl = vdupq_n_u8(0x1f);
+        uint8x16_t prev = vdupq_n_u8(0);
+        bool open = false;
+        while (end - p >= 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) p);
+            uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)), vcleq_u8(v, ctrl));
+            unsigned long long stop = cson__neon_mask(hit);
+            unsigned long long high = cson__neon_mask(vcgeq_u8(v, vdupq_n_u8(0x80)));
+            if (!(high | open)) {
+                if (stop) { p += cson__ctz(stop)/4; goto found; }
+                p += 16;
+                continue;
+            }
+            unsigned long long bad = cson__neon_mask(cson__utf8_errors(v, prev));
+            if (stop && cson__ctz(stop) < 60) bad &= (16ull << cson__ctz(stop)) - 1;
+            if (bad) goto slow;
+            if (stop) { p += cson__ctz(stop)/4; goto found; }
+            prev = v;
+            p += 16;
+            open = cson__utf8_open(p);
+        }
+#endif
+#if defined(CSON__SIMD)
+        if (open) {
+        slow:
+            // back to the lead byte of a sequence begun in the previous vector
+            if (open) do p--; while (p > begin && ((unsigned char) *p & 0xc0) == 0x80);
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\' && (signed char) *p >= 0x20) p++;
+#if defined(CSON__SIMD)
+    found:
+#endif
+        if (p >= end || *p == '"') return p;
+        const char *next;
+        if (*p == '\\') {
+            *escaped = true;
+            next = cson__check_escape(p, end);
+            *error = CSON_ERROR_ESCAPE;
+        } else if ((unsigned char) *p >= 0x80) {
+            next = cson__check_utf8(p, end);
+            *error = CSON_ERROR_UTF8;
+        } else {
+            next = NULL;
+            *error = CSON_ERROR_ESCAPE;
+        }
+        if (!next) return p;
+        p = next;
+    }
+}
+
+// cson__scan_escape - find the next byte a json string must escape
+// @p: string bytes
+// @end: end of the string
+// Note: looks for '"', '\\' and control bytes, bytes above 0x7f pass
+// Return: pointer to that byte, or end
+static const char *cson__scan_escape(const char *p, const char *end) {
+#if defined(CSON__AVX2)
+    const __m256i quote = _mm256_set1_epi8('"'), bslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl = _mm256_set1_epi8(0x1f);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(hit);
+        if (mask) return p + cson__ctz(mask);
+        p += 32;
+    }
+#elif defined(CSON__SSE2)
+    const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+        unsigned mask = (unsigned) _mm_movemask_epi8(hit);
+        if (mask) return p + cson__ctz(mask);
+        p += 16;
+    }
+#elif defined(CSON__NEON)
+    const uint8x16_t quote = vdupq_n_u8('"'), bslash = vdupq_n_u8('\\'), ctrl = vdupq_n_u8(0x1f);
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *) p);
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, bslash)), vcleq_u8(v, ctrl));
+        unsigned long long mask = cson__neon_mask(hit);
+        if (mask) return p + cson__ctz(mask)/4;
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20) p++;
+    return p;
+}
+
+// cson__utf8_encode - encode a code point as utf-8
+// @out: output (at least 4 bytes)
+// @cp: code point, not a surrogate
+// Return: byte count
+static size_t cson__utf8_encode(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char) cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char) (0xc0 | cp >> 6);
+        out[1] = (char) (0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char) (0xe0 | cp >> 12);
+        out[1] = (char) (0x80 | (cp >> 6 & 0x3f));
+        out[2] = (char) (0x80 | (cp & 0x3f));
+        return 3;
+    }
+    out[0] = (char) (0xf0 | cp >> 18);
+    out[1] = (char) (0x80 | (cp >> 12 & 0x3f));
+    out[2] = (char) (0x80 | (cp >> 6 & 0x3f));
+    out[3] = (char) (0x80 | (cp & 0x3f));
+    return 4;
+}
+
+// cson__unescape - decode the body of a checked string token
+// @dst: output of at least len bytes, may be src itself
+// @src: token text
+// @len: token length
+// Note: the text went through cson__check_string, so every escape is whole;
+//       a decoded escape is never longer than its source, which lets in-situ
+//       parsers decode in place; a vector is stored whole (out never runs
+//       ahead of src, so it stays inside dst) unless that would overwrite the
+//       bytes behind a '\\' that an in-place decode has yet to read
+// Return: decoded length
+static size_t cson__unescape(char *dst, const char *src, size_t len) {
+    const char *end = src + len;
+#if defined(CSON__SIMD)
+    const bool apart = dst != src;
+#endif
+    char *out = dst;
+    while (1) {
+        size_t run = 0;
+#if defined(CSON__AVX2)
+        const __m256i bslash = _mm256_set1_epi8('\\');
+        while (end - src >= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) src);
+            unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bslash));
+            if (mask && !apart) { run = cson__ctz(mask); goto found; }
+            _mm256_storeu_si256((__m256i *) out, v);
+            if (mask) { src += cson__ctz(mask); out += cson__ctz(mask); goto found; }
+            src += 32;
+            out += 32;
+        }
+#elif defined(CSON__SSE2)
+        const __m128i bslash = _mm_set1_epi8('\\');
+        while (end - src >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) src);
+            unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, bslash));
+            if (mask && !apart) { run = cson__ctz(mask); goto found; }
+            _mm_storeu_si128((__m128i *) out, v);
+            if (mask) { src += cson__ctz(mask); out += cson__ctz(mask); goto found; }
+            src += 16;
+            out += 16;
+        }
+#elif defined(CSON__NEON)
+        const uint8x16_t bslash = vdupq_n_u8('\\');
+        while (end - src >= 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *) src);
+            unsigned long long mask = cson__neon_mask(vceqq_u8(v, bslash));
+            if (mask && !apart) { run = cson__ctz(mask)/4; goto found; }
+            vst1q_u8((uint8_t *) out, v);
+            if (mask) { src += cson__ctz(mask)/4; out += cson__ctz(mask)/4; goto found; }
+            src += 16;
+            out += 16;
+        }
+#endif
+        while (src + run < end && src[run] != '\\') run++;
+#if defined(CSON__SIMD)
+    found:
+#endif
+        if (run) {
+            memmove(out, src, run);
+            out += run;
+            src += run;
+        }
+        if (src >= end) break;
+        const char *bs = src;
+        src = bs + 2;
+        switch (bs[1]) {
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+            uint32_t cp = cson__hex4_checked(src), lo;
+            src += 4;
+            if (cp >= 0xd800 && cp <= 0xdbff) {
+                lo = cson__hex4_checked(src + 2);
+                src += 6;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+            }
+            out += cson__utf8_encode(out, cp);
+        } break;
+        default: *out++ = bs[1]; break; // '"', '\\' or '/'
+        }
+    }
+    return (size_t) (out - dst);
+}
+
+// cson__is_bracket - check for '{', '}', '[' or ']'
+// Note: '[' and ']' differ from '{' and '}' only in bit 0x20
+#define cson__is_bracket(ch) (((ch) | 0x20) == '{' || ((ch) | 0x20) == '}')
+
+// cson__scan_structural - find the next quote or bracket
+// @p: current position
+// @end: end of input
+// Return: pointer to '"', '{', '}', '[' or ']', or end
+static const char *cson__scan_structural(const char *p, const char *end) {
+#if defined(CSON__AVX2)
+    const __m256i quote = _mm256_set1_epi8('"'), bit = _mm256_set1_epi8(0x20);
+    const __m256i lcurly = _mm256_set1_epi8('{'), rcurly = _mm256_set1_epi8('}');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i folded = _mm256_or_si256(v, bit);
+        unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, lcurly), _mm256_cmpeq_epi8(folded, rcurly))));
+        if (mask) return p + cson__ctz(mask);
+        p += 32;
+    }
+#elif defined(CSON__SSE2)
+    const __m128i quote = _mm_set1_epi8('"'), bit = _mm_set1_epi8(0x20);
+    const __m128i lcurly = _mm_set1_epi8('{'), rcurly = _mm_set1_epi8('}');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i folded = _mm_or_si128(v, bit);
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+            _mm_or_si128(_mm_cmpeq_epi8(folded, lcurly), _mm_cmpeq_epi8(folded, rcurly))));
+        if (mask) return p + cson__ctz(mask);
+        p += 16;
+    }
+#elif defined(CSON__NEON)
+    const uint8x16_t quote = vdupq_n_u8('"'), bit = vdupq_n_u8(0x20);
+    const uint8x16_t lcurly = vdupq_n_u8('{'), rcurly = vdupq_n_u8('}');
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *) p);
+        uint8x16_t folded = vorrq_u8(v, bit);
+        unsigned long long mask = cson__neon_mask(vorrq_u8(vceqq_u8(v, quote),
+            vorrq_u8(vceqq_u8(folded, lcurly), vceqq_u8(folded, rcurly))));
+        if (mask) return p + cson__ctz(mask)/4;
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && !cson__is_bracket(*p)) p++;
+    return p;
+}
+
+// cson__skip_container - find the end of an object or array without parsing it
+// @p: opening '{' or '['
+// @end: end of input
+// Note: only strings and brackets are looked at, the rest is not validated
+// Return: pointer past the matching bracket, NULL if it is unterminated
+static const char *cson__skip_container(const char *p, const char *end) {
+    size_t depth = 0;
+    while ((p = cson__scan_structural(p, end)) < end) {
+        switch (*p) {
+        case '"':
+            p = cson__scan_string(p + 1, end);
+            if (p >= end) return NULL;
+            p++;
+            break;
+        case '{': case '[':
+            depth++;
+            p++;
+            break;
+        default:
+            p++;
+            if (--depth == 0) return p;
+            break;
+        }
+    }
+    return NULL;
+}
+
+// cson__make_punc - make a punctuation token
 // @lex: pointer to lexer
-// Return: a eof token
-static cson_token_t cson__make_eof(cson_lexer_t *lex) {
-    (void) lex;
+// @kind: token type
+// Return: a punctuation (length = 1) token
+static cson_token_t cson__make_punc(cson_lexer_t *lex, cson_token_kind_t kind) {
+    return (cson_token_t) {
+        .kind = kind,
+        .escaped = false,
+        .start = lex->current++,
+        .len = 1
+    };
+}
+
+// cson__make_partial - make a eof token for a token cut by the end of input
+// @lex: pointer to partial lexer
+// Note: nothing is consumed, the token starts again at lex->start
+// Return: a eof token whose start is before the end of input
+static cson_token_t cson__make_partial(cson_lexer_t *lex) {
+    lex->current = lex->start;
     return (cson_token_t) {
         .kind = CSON_TK_EOF,
+        .escaped = false,
         .start = lex->start,
-        .len = 1
+        .len = 0
+    };
+}
+
+// cson__make_error - record an error of a recovering lexer
+// @lex: pointer to lexer
+// @code: error code
+// @at: offending text
+// Note: the rest of the input is dropped, so every later token is eof and
+//       the parser unwinds without building anything else, the error
+//       earliest in the text is kept since the lookahead may fail first
+// Return: a eof token at the end of input
+static cson_token_t cson__make_error(cson_lexer_t *lex, cson_error_code_t code, const char *at) {
+    if (lex->error == CSON_OK || at < lex->error_at) {
+        lex->error = code;
+        lex->error_at = at;
+    }
+    lex->current = lex->end;
+    lex->start = lex->end;
+    return (cson_token_t) {
+        .kind = CSON_TK_EOF,
+        .escaped = false,
+        .start = lex->end,
+        .len = 0
     };
 }
 
-static cson_token_t cson__get_next_token(cson_lexer_t *lex) {
-    // skip whitespace
-    while (isspace(*lex->current)) lex->current++;
-    lex->start = lex->current;
+// cson__nul_escape - find a \u0000 escape
+// @s: string text, its escapes already checked
+// @end: closing '"'
+// Note: the tree hands strings out as C strings, which would end at the NUL
+// Return: the backslash of the escape, NULL if there is none
+static const char *cson__nul_escape(const char *s, const char *end) {
+    while ((s = (const char *) memchr(s, '\\', (size_t) (end - s)))) {
+        if (s[1] == 'u' && s[2] == '0' && s[3] == '0' && s[4] == '0' && s[5] == '0') return s;
+        s += 2;
+    }
+    return NULL;
+}
+
+// cson__make_string - make string token
+// @lex: pointer to lexer
+// Note: escape sequences and utf-8 are checked but kept in the token text,
+//       escaped tells the consumers whether cson__unescape has work to do
+// Return: a string (exclude '"') token
+static cson_token_t cson__make_string(cson_lexer_t *lex) {
+    bool escaped = false;
+    cson_error_code_t error = CSON_OK;
+    const char *close = cson__check_string(lex->current + 1, lex->end, &escaped, &error);
+    if (close >= lex->end) {
+        if (lex->partial) return cson__make_partial(lex);
+        if (lex->recover) return cson__make_error(lex, CSON_ERROR_STRING, lex->start);
+        cson__fatal("unterminated string at '%.*s'", 16, lex->start);
+    }
+    if (*close != '"') {
+        if (lex->recover) return cson__make_error(lex, error, close);
+        if (error == CSON_ERROR_UTF8) cson__fatal("invalid utf-8 in string at '%.*s'", 16, lex->start);
+        cson__fatal("invalid escape at '%.*s'", (int) (lex->end - close < 6 ? lex->end - close : 6), close);
+    }
+    if (escaped && !lex->keep_nul) {
+        const char *nul = cson__nul_escape(lex->current + 1, close);
+        if (nul) {
+            if (lex->recover) return cson__make_error(lex, CSON_ERROR_ESCAPE, nul);
+            cson__fatal("\\u0000 in string at '%.*s'", 6, nul);
+        }
+    }
+    lex->current = close + 1;
+    return (cson_token_t) {
+        .kind = CSON_TK_STRING,
+        .escaped = escaped,
+        .start = lex->start + 1,
+        .len = (size_t) (close - lex->start - 1)
+    };
+}
+
+// cson__make_number - make number token
+// @lex: pointer to lexer
+// Note: follows the json grammar: '-'? int frac? exp?
+// Return: a number (include sign, '.' and exponent) token
+static cson_token_t cson__make_number(cson_lexer_t *lex) {
+    const char *p = lex->current, *end = lex->end;
+    if (*p == '-') p++;
+    if (p >= end || !cson__is_digit(*p)) goto fail;
+    if (*p == '0') p++;
+    else while (p < end && cson__is_digit(*p)) p++;
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !cson__is_digit(*p)) goto fail;
+        while (p < end && cson__is_digit(*p)) p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (p >= end || !cson__is_digit(*p)) goto fail;
+        while (p < end && cson__is_digit(*p)) p++;
+    }
+    if (p >= end && lex->partial) return cson__make_partial(lex);
+    lex->current = p;
+    return (cson_token_t) {
+        .kind = CSON_TK_NUMBER,
+        .escaped = false,
+        .start = lex->start,
+        .len = (size_t) (lex->current - lex->start)
+    };
+fail:
+    if (p >= end && lex->partial) return cson__make_partial(lex);
+    if (lex->recover) return cson__make_error(lex, CSON_ERROR_NUMBER, lex->start);
+    cson__fatal("invalid number at '%.*s'", (int) (p - lex->start + (p < end)), lex->start);
+}
+
+// cson__make_literal - make literal token
+// @lex: pointer to lexer
+// Note: only support null/true/false
+// Return: a literal token
+static cson_token_t cson__make_literal(cson_lexer_t *lex) {
+    cson_token_t token;
+    const char *text;
+    switch (*lex->start) {
+    case 'f': token.kind = CSON_TK_FALSE; text = "false"; break;
+    case 'n': token.kind = CSON_TK_NULL;  text = "null";  break;
+    default:  token.kind = CSON_TK_TRUE;  text = "true";  break;
+    }
+    size_t len = strlen(text);
+    size_t avail = (size_t) (lex->end - lex->start);
+    if (avail < len && lex->partial && memcmp(lex->start, text, avail) == 0) {
+        return cson__make_partial(lex);
+    }
+    if (avail < len || memcmp(lex->start, text, len) != 0) {
+        if (lex->recover) return cson__make_error(lex, CSON_ERROR_LITERAL, lex->start);
+        cson__fatal("unknown literal at '%.*s'", (int) len, lex->start);
+    }
+    lex->current += len;
+    token.escaped = false;
+    token.start = lex->start;
+    token.len = len;
+    return token;
+}
+
+// cson__make_eof - make a eof token
+// @lex: pointer to lexer
+// Return: a eof token
+static cson_token_t cson__make_eof(cson_lexer_t *lex) {
+    (void) lex;
+    return (cson_token_t) {
+        .kind = CSON_TK_EOF,
+        .escaped = false,
+        .start = lex->start,
+        .len = 0
+    };
+}
+
+static cson_token_t cson__next_token(cson_lexer_t *lex) {
+    lex->current = cson__skip_space(lex->current, lex->end);
+    lex->start = lex->current;
+    if (lex->current >= lex->end) return cson__make_eof(lex);
+
+    char ch = *lex->start;
+    if (cson__is_digit(ch) || ch == '-') return cson__make_number(lex);
+    switch (ch) {
+    case '"': return cson__make_string(lex);
+    case '{': return cson__make_punc(lex, CSON_TK_LCURLY);
+    case '}': return cson__make_punc(lex, CSON_TK_RCURLY);
+    case '[': return cson__make_punc(lex, CSON_TK_LSQUARE);
+    case ']': return cson__make_punc(lex, CSON_TK_RSQUARE);
+    case ':': return cson__make_punc(lex, CSON_TK_COLON);
+    case ',': return cson__make_punc(lex, CSON_TK_COMMA);
+    case 't': case 'f': case 'n': return cson__make_literal(lex);
+    default:
+        if (lex->recover) return cson__make_error(lex, CSON_ERROR_CHARACTER, lex->start);
+        cson__fatal("unknown character: %c", ch);
+    }
+}
+
+#if defined(CSON_ENABLE_STATS)
+// cson__get_next_token - lex the next token and count it
+// @lex: pointer to lexer
+// Return: next token
+static cson_token_t cson__get_next_token(cson_lexer_t *lex) {
+    CSON__STAT_CLOCK(start);
+    cson_token_t token = cson__next_token(lex);
+    CSON__STAT_ADD(lex_seconds, CSON__STAT_SINCE(start));
+    CSON__STAT_ADD(tokens, 1);
+    return token;
+}
+#else
+#define cson__get_next_token cson__next_token
+#endif
+
+// cson__strndup - strndup
+// @s: original string (Nullable)
+// @len: duplicate length
+// Note: C99 not support strndup
+// Return: duplicate string
+static char *cson__strndup(const char *s, size_t len) {
+    if (!s) return NULL;
+    char *p = (char *) cson__malloc(len + 1);
+    memcpy(p, s, len);
+    p[len] = '\0';
+    return p;
+}
+
+#define CSON__ARENA_ALIGN sizeof(void *)
+
+// cson__arena_alloc - bump allocate from arena
+// @arena: pointer to arena
+// @size: allocation size
+// Note: abort if out of memory
+// Return: pointer aligned to CSON__ARENA_ALIGN
+static void *cson__arena_alloc(cson_arena_t *arena, size_t size) {
+    size = (size + CSON__ARENA_ALIGN - 1) & ~(CSON__ARENA_ALIGN - 1);
+
+    cson_arena_block_t *block = arena->cur;
+    while (block && block->used + size > block->cap) block = block->next;
+    if (!block) {
+        cson_arena_block_t *tail = arena->cur;
+        while (tail && tail->next) tail = tail->next;
+        size_t cap = tail ? 2*tail->cap : CSON_ARENA_BLOCK_SIZE;
+        if (cap < size) cap = size;
+        block = (cson_arena_block_t *) cson__malloc(sizeof(cson_arena_block_t) + cap);
+        block->next = NULL;
+        block->cap = cap;
+        block->used = 0;
+        if (tail) tail->next = block;
+        else arena->first = block;
+    }
+    arena->cur = block;
+
+    void *p = (char *) (block + 1) + block->used;
+    block->used += size;
+    return p;
+}
+
+// cson__arena_reset - rewind arena but keep its blocks
+// @arena: pointer to arena
+static void cson__arena_reset(cson_arena_t *arena) {
+    for (cson_arena_block_t *block = arena->first; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->cur = arena->first;
+}
+
+// cson__arena_free - release all blocks of arena
+// @arena: pointer to arena
+static void cson__arena_free(cson_arena_t *arena) {
+    cson_arena_block_t *block = arena->first;
+    while (block) {
+        cson_arena_block_t *next = block->next;
+        cson__free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->cur = NULL;
+}
+
+typedef struct {
+    cson_lexer_t lex;
+    cson_token_t look;    // lookahead token, lexed exactly once
+    cson_arena_t *arena;  // NULL if the tree is heap allocated
+    bool insitu;          // keys and strings point into the mutable input
+    cson_keytab_t *keys;  // intern keys into this table (Nullable)
+    cson_doc_t *lazy;     // leave nested containers unparsed in this doc (Nullable)
+    cson_nodes_t stack;   // open containers and their finished children
+    size_t open;          // stack index of the innermost open container
+    size_t depth;         // containers open right now, at most CSON_MAX_DEPTH
+} cson__parser_t;
+
+// cson__advance - consume the lookahead token and lex the next one
+// @p: pointer to parser
+// Return: consumed token
+static cson_token_t cson__advance(cson__parser_t *p) {
+    cson_token_t token = p->look;
+    p->look = cson__get_next_token(&p->lex);
+    return token;
+}
+
+// cson__parser_fail - stop a recovering parser at an unexpected token
+// @p: pointer to parser
+// @token: offending token
+// Note: the lookahead becomes eof, so every open container closes at once
+static void cson__parser_fail(cson__parser_t *p, cson_token_t token) {
+    cson_error_code_t code = token.kind == CSON_TK_EOF ? CSON_ERROR_EOF : CSON_ERROR_SYNTAX;
+    p->look = cson__make_error(&p->lex, code, token.start);
+}
+
+// cson__expect - consume the lookahead token and check the kind
+// @p: pointer to parser
+// @kind: expected kind
+// Note: if it is unexpected, just abort, a recovering parser fails instead
+//       and returns the eof lookahead
+// Return: the expected token
+static cson_token_t cson__expect(cson__parser_t *p, cson_token_kind_t kind) {
+    if (p->look.kind != kind) {
+        if (!p->lex.recover) cson__fatal("expect %d, but got %d at '%.*s'",
+                                         kind, p->look.kind, (int) p->look.len, p->look.start);
+        cson__parser_fail(p, p->look);
+        return p->look;
+    }
+    return cson__advance(p);
+}
+
+// cson__parser_alloc - allocate tree memory
+// @p: pointer to parser
+// @size: allocation size
+// Return: arena memory if the parser has arena, otherwise heap memory
+static void *cson__parser_alloc(cson__parser_t *p, size_t size) {
+    if (p->arena) return cson__arena_alloc(p->arena, size);
+    return cson__malloc(size);
+}
+
+// cson__parser_string - decode string token text into the tree
+// @p: pointer to parser
+// @token: string token
+// Note: in-situ parsers decode and terminate the text in place instead, which
+//       is safe because the lexer has already moved past the closing '"' and
+//       decoding never makes the text longer
+// Return: NUL-terminated copy or the text itself
+static char *cson__parser_string(cson__parser_t *p, cson_token_t token) {
+    char *dst;
+    if (p->insitu) dst = (char *) token.start;
+    else if (!p->arena) dst = (char *) cson__malloc(token.len + 1);
+    else dst = (char *) cson__arena_alloc(p->arena, token.len + 1);
+    size_t len = token.len;
+    if (token.escaped) len = cson__unescape(dst, token.start, token.len);
+    else if (dst != token.start) memcpy(dst, token.start, token.len);
+    dst[len] = '\0';
+    return dst;
+}
+
+// cson__text_decode - decode a string token into a scratch buffer
+// @token: string token with escapes
+// @buf: scratch of CSON__TEXT_BUF bytes
+// @len: output decoded length
+// Return: buf, or a heap block for long text that the caller frees
+#define CSON__TEXT_BUF 256
+static char *cson__text_decode(cson_token_t token, char *buf, size_t *len) {
+    char *text = token.len <= CSON__TEXT_BUF ? buf : (char *) cson__malloc(token.len);
+    *len = cson__unescape(text, token.start, token.len);
+    return text;
+}
+
+// cson__nodes_push - append a node to a plain node array
+// @da: node array
+// @node: node
+static void cson__nodes_push(cson_nodes_t *da, cson_node_t node) {
+    if (da->len + 1 > da->cap) {
+        da->cap = cson__grow(da->cap, 64);
+        da->items = (cson_node_t *) cson__realloc(da->items, sizeof(cson_node_t)*da->cap);
+    }
+    da->items[da->len++] = node;
+}
+
+// cson__parser_push - push a finished child onto the scratch stack
+// @p: pointer to parser
+// @node: child node
+static void cson__parser_push(cson__parser_t *p, cson_node_t node) {
+    cson__nodes_push(&p->stack, node);
+}
+
+// cson__parser_close - pop the children of a container from the scratch stack
+// @p: pointer to parser
+// @kind: container type
+// @base: stack length when the container was opened
+// Note: children are moved into one exactly sized allocation, large objects
+//       also get their hash index there
+// Return: container node without key yet
+static cson_node_t cson__parser_close(cson__parser_t *p, cson_node_kind_t kind, size_t base) {
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+    node.kind = kind;
+    node.flags = p->arena ? CSON_FLAG_ARENA : 0;
+
+    uint32_t len = p->stack.len - (uint32_t) base;
+    if (len > 0) {
+        bool indexed = kind == CSON_OBJECT && len >= CSON_INDEX_THRESHOLD;
+        node.as.container.items = (cson_node_t *) cson__parser_alloc(p, cson__items_size(len, indexed));
+        memcpy(node.as.container.items, p->stack.items + base, sizeof(cson_node_t)*len);
+        node.as.container.len = len;
+        node.as.container.cap = len;
+        if (indexed) {
+            node.flags |= CSON_FLAG_INDEXED;
+            cson__index_build(&node.as.container);
+        }
+    }
+    p->stack.len = base;
+    CSON__STAT_ADD(nodes, 1);
+    return node;
+}
+
+// exactly representable powers of ten for the fast float path
+static const double cson__pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// 128-bit truncations of 5^q for q in [-342, 308], high word first, each
+// shifted so its top bit is set (the table of the Eisel-Lemire algorithm)
+#define CSON__POW5_MIN -342
+#define CSON__POW5_MAX 308
+static const uint64_t cson__pow5_128[] = {
+    0xeef453d6923bd65aull, 0x113faa2906a13b3full, 0x9558b4661b6565f8ull, 0x4ac7ca59a424c507ull,
+    0xbaaee17fa23ebf76ull, 0x5d79bcf00d2df649ull, 0xe95a99df8ace6f53ull, 0xf4d82c2c107973dcull,
+    0x91d8a02bb6c10594ull, 0x79071b9b8a4be869ull, 0xb64ec836a47146f9ull, 0x9748e2826cdee284ull,
+    0xe3e27a444d8d98b7ull, 0xfd1b1b2308169b25ull, 0x8e6d8c6ab0787f72ull, 0xfe30f0f5e50e20f7ull,
+    0xb208ef855c969f4full, 0xbdbd2d335e51a935ull, 0xde8b2b66b3bc4723ull, 0xad2c788035e61382ull,
+    0x8b16fb203055ac76ull, 0x4c3bcb5021afcc31ull, 0xaddcb9e83c6b1793ull, 0xdf4abe242a1bbf3dull,
+    0xd953e8624b85dd78ull, 0xd71d6dad34a2af0dull, 0x87d4713d6f33aa6bull, 0x8672648c40e5ad68ull,
+    0xa9c98d8ccb009506ull, 0x680efdaf511f18c2ull, 0xd43bf0effdc0ba48ull, 0x0212bd1b2566def2ull,
+    0x84a57695fe98746dull, 0x014bb630f7604b57ull, 0xa5ced43b7e3e9188ull, 0x419ea3bd35385e2dull,
+    0xcf42894a5dce35eaull, 0x52064cac828675b9ull, 0x818995ce7aa0e1b2ull, 0x7343efebd1940993ull,
+    0xa1ebfb4219491a1full, 0x1014ebe6c5f90bf8ull, 0xca66fa129f9b60a6ull, 0xd41a26e077774ef6ull,
+    0xfd00b897478238d0ull, 0x8920b098955522b4ull, 0x9e20735e8cb16382ull, 0x55b46e5f5d5535b0ull,
+    0xc5a890362fddbc62ull, 0xeb2189f734aa831dull, 0xf712b443bbd52b7bull, 0xa5e9ec7501d523e4ull,
+    0x9a6bb0aa55653b2dull, 0x47b233c92125366eull, 0xc1069cd4eabe89f8ull, 0x999ec0bb696e840aull,
+    0xf148440a256e2c76ull, 0xc00670ea43ca250dull, 0x96cd2a865764dbcaull, 0x380406926a5e5728ull,
+    0xbc807527ed3e12bcull, 0xc605083704f5ecf2ull, 0xeba09271e88d976bull, 0xf7864a44c633682eull,
+    0x93445b8731587ea3ull, 0x7ab3ee6afbe0211dull, 0xb8157268fdae9e4cull, 0x5960ea05bad82964ull,
+    0xe61acf033d1a45dfull, 0x6fb92487298e33bdull, 0x8fd0c16206306babull, 0xa5d3b6d479f8e056ull,
+    0xb3c4f1ba87bc8696ull, 0x8f48a4899877186cull, 0xe0b62e2929aba83cull, 0x331acdabfe94de87ull,
+    0x8c71dcd9ba0b4925ull, 0x9ff0c08b7f1d0b14ull, 0xaf8e5410288e1b6full, 0x07ecf0ae5ee44dd9ull,
+    0xdb71e91432b1a24aull, 0xc9e82cd9f69d6150ull, 0x892731ac9faf056eull, 0xbe311c083a225cd2ull,
+    0xab70fe17c79ac6caull, 0x6dbd630a48aaf406ull, 0xd64d3d9db981787dull, 0x092cbbccdad5b108ull,
+    0x85f0468293f0eb4eull, 0x25bbf56008c58ea5ull, 0xa76c582338ed2621ull, 0xaf2af2b80af6f24eull,
+    0xd1476e2c07286faaull, 0x1af5af660db4aee1ull, 0x82cca4db847945caull, 0x50d98d9fc890ed4dull,
+    0xa37fce126597973cull, 0xe50ff107bab528a0ull, 0xcc5fc196fefd7d0cull, 0x1e53ed49a96272c8ull,
+    0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7aull, 0x9faacf3df73609b1ull, 0x77b191618c54e9acull,
+    0xc795830d75038c1dull, 0xd59df5b9ef6a2417ull, 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1dull,
+    0x9becce62836ac577ull, 0x4ee367f9430aec32ull, 0xc2e801fb244576d5ull, 0x229c41f793cda73full,
+    0xf3a20279ed56d48aull, 0x6b43527578c1110full, 0x9845418c345644d6ull, 0x830a13896b78aaa9ull,
+    0xbe5691ef416bd60cull, 0x23cc986bc656d553ull, 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa8ull,
+    0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6a9ull, 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc53ull,
+    0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff68ull, 0x91376c36d99995beull, 0x23100809b9c21fa1ull,
+    0xb58547448ffffb2dull, 0xabd40a0c2832a78aull, 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516cull,
+    0x8dd01fad907ffc3bull, 0xae3da7d97f6792e3ull, 0xb1442798f49ffb4aull, 0x99cd11cfdf41779cull,
+    0xdd95317f31c7fa1dull, 0x40405643d711d583ull, 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2572ull,
+    0xad1c8eab5ee43b66ull, 0xda3243650005eecfull, 0xd863b256369d4a40ull, 0x90bed43e40076a82ull,
+    0x873e4f75e2224e68ull, 0x5a7744a6e804a291ull, 0xa90de3535aaae202ull, 0x711515d0a205cb36ull,
+    0xd3515c2831559a83ull, 0x0d5a5b44ca873e03ull, 0x8412d9991ed58091ull, 0xe858790afe9486c2ull,
+    0xa5178fff668ae0b6ull, 0x626e974dbe39a872ull, 0xce5d73ff402d98e3ull, 0xfb0a3d212dc8128full,
+    0x80fa687f881c7f8eull, 0x7ce66634bc9d0b99ull, 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e80ull,
+    0xc987434744ac874eull, 0xa327ffb266b56220ull, 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa8ull,
+    0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4a9ull, 0xc4ce17b399107c22ull, 0xcb550fb4384d21d3ull,
+    0xf6019da07f549b2bull, 0x7e2a53a146606a48ull, 0x99c102844f94e0fbull, 0x2eda7444cbfc426dull,
+    0xc0314325637a1939ull, 0xfa911155fefb5308ull, 0xf03d93eebc589f88ull, 0x793555ab7eba27caull,
+    0x96267c7535b763b5ull, 0x4bc1558b2f3458deull, 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f16ull,
+    0xea9c227723ee8bcbull, 0x465e15a979c1cadcull, 0x92a1958a7675175full, 0x0bfacd89ec191ec9ull,
+    0xb749faed14125d36ull, 0xcef980ec671f667bull, 0xe51c79a85916f484ull, 0x82b7e12780e7401aull,
+    0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908810ull, 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa15ull,
+    0xdfbdcece67006ac9ull, 0x67a791e093e1d49aull, 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e0ull,
+    0xaecc49914078536dull, 0x58fae9f773886e18ull, 0xda7f5bf590966848ull, 0xaf39a475506a899eull,
+    0x888f99797a5e012dull, 0x6d8406c952429603ull, 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b83ull,
+    0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a64ull, 0x855c3be0a17fcd26ull, 0x5cf2eea09a55067full,
+    0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481eull, 0xd0601d8efc57b08bull, 0xf13b94daf124da26ull,
+    0x823c12795db6ce57ull, 0x76c53d08d6b70858ull, 0xa2cb1717b52481edull, 0x54768c4b0c64ca6eull,
+    0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd09ull, 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4cull,
+    0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6dafull, 0xc6b8e9b0709f109aull, 0x359ab6419ca1091bull,
+    0xf867241c8cc6d4c0ull, 0xc30163d203c94b62ull, 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1dull,
+    0xc21094364dfb5636ull, 0x985915fc12f542e4ull, 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939dull,
+    0x979cf3ca6cec5b5aull, 0xa705992ceecf9c42ull, 0xbd8430bd08277231ull, 0x50c6ff782a838353ull,
+    0xece53cec4a314ebdull, 0xa4f8bf5635246428ull, 0x940f4613ae5ed136ull, 0x871b7795e136be99ull,
+    0xb913179899f68584ull, 0x28e2557b59846e3full, 0xe757dd7ec07426e5ull, 0x331aeada2fe589cfull,
+    0x9096ea6f3848984full, 0x3ff0d2c85def7621ull, 0xb4bca50b065abe63ull, 0x0fed077a756b53a9ull,
+    0xe1ebce4dc7f16dfbull, 0xd3e8495912c62894ull, 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95cull,
+    0xb080392cc4349decull, 0xbd8d794d96aacfb3ull, 0xdca04777f541c567ull, 0xecf0d7a0fc5583a0ull,
+    0x89e42caaf9491b60ull, 0xf41686c49db57244ull, 0xac5d37d5b79b6239ull, 0x311c2875c522ced5ull,
+    0xd77485cb25823ac7ull, 0x7d633293366b828bull, 0x86a8d39ef77164bcull, 0xae5dff9c02033197ull,
+    0xa8530886b54dbdebull, 0xd9f57f830283fdfcull, 0xd267caa862a12d66ull, 0xd072df63c324fd7bull,
+    0x8380dea93da4bc60ull, 0x4247cb9e59f71e6dull, 0xa46116538d0deb78ull, 0x52d9be85f074e608ull,
+    0xcd795be870516656ull, 0x67902e276c921f8bull, 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b6ull,
+    0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a4ull, 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2cdull,
+    0xfad2a4b13d1b5d6cull, 0x796b805720085f81ull, 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb0ull,
+    0xc3f490aa77bd60fcull, 0xbedbfc4411068a9cull, 0xf4f1b4d515acb93bull, 0xee92fb5515482d44ull,
+    0x991711052d8bf3c5ull, 0x751bdd152d4d1c4aull, 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635dull,
+    0xef340a98172aace4ull, 0x86fb897116c87c34ull, 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da0ull,
+    0xbae0a846d2195712ull, 0x8974836059cca109ull, 0xe998d258869facd7ull, 0x2bd1a438703fc94bull,
+    0x91ff83775423cc06ull, 0x7b6306a34627ddcfull, 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d542ull,
+    0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a93ull, 0x8e938662882af53eull, 0x547eb47b7282ee9cull,
+    0xb23867fb2a35b28dull, 0xe99e619a4f23aa43ull, 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d4ull,
+    0x8b3c113c38f9f37eull, 0xde83bc408dd3dd04ull, 0xae0b158b4738705eull, 0x9624ab50b148d445ull,
+    0xd98ddaee19068c76ull, 0x3badd624dd9b0957ull, 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d6ull,
+    0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4cull, 0xd47487cc8470652bull, 0x7647c3200069671full,
+    0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e073ull, 0xa5fb0a17c777cf09ull, 0xf468107100525890ull,
+    0xcf79cc9db955c2ccull, 0x7182148d4066eeb4ull, 0x81ac1fe293d599bfull, 0xc6f14cd848405530ull,
+    0xa21727db38cb002full, 0xb8ada00e5a506a7cull, 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851cull,
+    0xfd442e4688bd304aull, 0x908f4a166d1da663ull, 0x9e4a9cec15763e2eull, 0x9a598e4e043287feull,
+    0xc5dd44271ad3cdbaull, 0x40eff1e1853f29fdull, 0xf7549530e188c128ull, 0xd12bee59e68ef47cull,
+    0x9a94dd3e8cf578b9ull, 0x82bb74f8301958ceull, 0xc13a148e3032d6e7ull, 0xe36a52363c1faf01ull,
+    0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac1ull, 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0b9ull,
+    0xbcb2b812db11a5deull, 0x7415d448f6b6f0e7ull, 0xebdf661791d60f56ull, 0x111b495b3464ad21ull,
+    0x936b9fcebb25c995ull, 0xcab10dd900beec34ull, 0xb84687c269ef3bfbull, 0x3d5d514f40eea742ull,
+    0xe65829b3046b0afaull, 0x0cb4a5a3112a5112ull, 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72abull,
+    0xb3f4e093db73a093ull, 0x59ed216765690f56ull, 0xe0f218b8d25088b8ull, 0x306869c13ec3532cull,
+    0x8c974f7383725573ull, 0x1e414218c73a13fbull, 0xafbd2350644eeacfull, 0xe5d1929ef90898faull,
+    0xdbac6c247d62a583ull, 0xdf45f746b74abf39ull, 0x894bc396ce5da772ull, 0x6b8bba8c328eb783ull,
+    0xab9eb47c81f5114full, 0x066ea92f3f326564ull, 0xd686619ba27255a2ull, 0xc80a537b0efefebdull,
+    0x8613fd0145877585ull, 0xbd06742ce95f5f36ull, 0xa798fc4196e952e7ull, 0x2c48113823b73704ull,
+    0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c5ull, 0x82ef85133de648c4ull, 0x9a984d73dbe722fbull,
+    0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbaull, 0xcc963fee10b7d1b3ull, 0x318df905079926a8ull,
+    0xffbbcfe994e5c61full, 0xfdf17746497f7052ull, 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa633ull,
+    0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc0ull, 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b0ull,
+    0x9c1661a651213e2dull, 0x06bea10ca65c084eull, 0xc31bfa0fe5698db8ull, 0x486e494fcff30a62ull,
+    0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfaull, 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01cull,
+    0xbe89523386091465ull, 0xf6bbb397f1135823ull, 0xee2ba6c0678b597full, 0x746aa07ded582e2cull,
+    0x94db483840b717efull, 0xa8c2a44eb4571cdcull, 0xba121a4650e4ddebull, 0x92f34d62616ce413ull,
+    0xe896a0d7e51e1566ull, 0x77b020baf9c81d17ull, 0x915e2486ef32cd60ull, 0x0ace1474dc1d122eull,
+    0xb5b5ada8aaff80b8ull, 0x0d819992132456baull, 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c69ull,
+    0x8df5efabc5979c8full, 0xca8d3ffa1ef463c1ull, 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb2ull,
+    0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull, 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull,
+    0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull, 0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull,
+    0x87625f056c7c4a8bull, 0x11471cd764ad4972ull, 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull,
+    0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull, 0x843610cb4bf160cbull, 0xcedf722a585139baull,
+    0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull, 0xce947a3da6a9273eull, 0x733d226229feea32ull,
+    0x811ccc668829b887ull, 0x0806357d5a3f525full, 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull,
+    0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull, 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull,
+    0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull, 0xc5029163f384a931ull, 0x0a9e795e65d4df11ull,
+    0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull, 0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull,
+    0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull, 0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull,
+    0x964e858c91ba2655ull, 0x3a6a07f8d510f86full, 0xbbe226efb628afeaull, 0x890489f70a55368bull,
+    0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull, 0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull,
+    0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull, 0xe55990879ddcaabdull, 0xcc420a6a101d0515ull,
+    0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull, 0xb32df8e9f3546564ull, 0x47939822dc96abf9ull,
+    0xdff9772470297ebdull, 0x59787e2b93bc56f7ull, 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull,
+    0xaefae51477a06b03ull, 0xede622920b6b23f1ull, 0xdab99e59958885c4ull, 0xe95fab368e45ecedull,
+    0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull, 0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull,
+    0xd59944a37c0752a2ull, 0x4be76d3346f0495full, 0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull,
+    0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull, 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull,
+    0x825ecc24c873782full, 0x8ed400668c0c28c8ull, 0xa2f67f2dfa90563bull, 0x728900802f0f32faull,
+    0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull, 0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull,
+    0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull, 0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull,
+    0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull, 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull,
+    0xc24452da229b021bull, 0xfbe85badce996168ull, 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull,
+    0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull, 0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull,
+    0xed246723473e3813ull, 0x290123e9aab23b68ull, 0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull,
+    0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull, 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull,
+    0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull, 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull,
+    0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull, 0x8d590723948a535full, 0x579c487e5a38ad0eull,
+    0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull, 0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull,
+    0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull, 0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full,
+    0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full, 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull,
+    0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull, 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull,
+    0x83a3eeeef9153e89ull, 0x1953cf68300424acull, 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull,
+    0xcdb02555653131b6ull, 0x3792f412cb06794dull, 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull,
+    0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull, 0xc8de047564d20a8bull, 0xf245825a5a445275ull,
+    0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull, 0x9ced737bb6c4183dull, 0x55464dd69685606bull,
+    0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull, 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull,
+    0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull, 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull,
+    0xef73d256a5c0f77cull, 0x963e66858f6d4440ull, 0x95a8637627989aadull, 0xdde7001379a44aa8ull,
+    0xbb127c53b17ec159ull, 0x5560c018580d5d52ull, 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull,
+    0x9226712162ab070dull, 0xcab3961304ca70e8ull, 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull,
+    0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull, 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull,
+    0xb267ed1940f1c61cull, 0x55f038b237591ed3ull, 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull,
+    0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull, 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull,
+    0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull, 0x881cea14545c7575ull, 0x7e50d64177da2e54ull,
+    0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull, 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull,
+    0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull, 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull,
+    0xcfb11ead453994baull, 0x67de18eda5814af2ull, 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull,
+    0xa2425ff75e14fc31ull, 0xa1258379a94d028dull, 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull,
+    0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull, 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull,
+    0xc612062576589ddaull, 0x95364afe032a819eull, 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull,
+    0x9abe14cd44753b52ull, 0xc4926a9672793543ull, 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull,
+    0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull, 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull,
+    0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull, 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull,
+    0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull, 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull,
+    0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull, 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull,
+    0xb424dc35095cd80full, 0x538484c19ef38c95ull, 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull,
+    0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull, 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull,
+    0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull, 0x89705f4136b4a597ull, 0x31680a88f8953031ull,
+    0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull, 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull,
+    0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull, 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull,
+    0xd1b71758e219652bull, 0xd3c36113404ea4a9ull, 0x83126e978d4fdf3bull, 0x645a1cac083126eaull,
+    0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull, 0xccccccccccccccccull, 0xcccccccccccccccdull,
+    0x8000000000000000ull, 0x0000000000000000ull, 0xa000000000000000ull, 0x0000000000000000ull,
+    0xc800000000000000ull, 0x0000000000000000ull, 0xfa00000000000000ull, 0x0000000000000000ull,
+    0x9c40000000000000ull, 0x0000000000000000ull, 0xc350000000000000ull, 0x0000000000000000ull,
+    0xf424000000000000ull, 0x0000000000000000ull, 0x9896800000000000ull, 0x0000000000000000ull,
+    0xbebc200000000000ull, 0x0000000000000000ull, 0xee6b280000000000ull, 0x0000000000000000ull,
+    0x9502f90000000000ull, 0x0000000000000000ull, 0xba43b74000000000ull, 0x0000000000000000ull,
+    0xe8d4a51000000000ull, 0x0000000000000000ull, 0x9184e72a00000000ull, 0x0000000000000000ull,
+    0xb5e620f480000000ull, 0x0000000000000000ull, 0xe35fa931a0000000ull, 0x0000000000000000ull,
+    0x8e1bc9bf04000000ull, 0x0000000000000000ull, 0xb1a2bc2ec5000000ull, 0x0000000000000000ull,
+    0xde0b6b3a76400000ull, 0x0000000000000000ull, 0x8ac7230489e80000ull, 0x0000000000000000ull,
+    0xad78ebc5ac620000ull, 0x0000000000000000ull, 0xd8d726b7177a8000ull, 0x0000000000000000ull,
+    0x878678326eac9000ull, 0x0000000000000000ull, 0xa968163f0a57b400ull, 0x0000000000000000ull,
+    0xd3c21bcecceda100ull, 0x0000000000000000ull, 0x84595161401484a0ull, 0x0000000000000000ull,
+    0xa56fa5b99019a5c8ull, 0x0000000000000000ull, 0xcecb8f27f4200f3aull, 0x0000000000000000ull,
+    0x813f3978f8940984ull, 0x4000000000000000ull, 0xa18f07d736b90be5ull, 0x5000000000000000ull,
+    0xc9f2c9cd04674edeull, 0xa400000000000000ull, 0xfc6f7c4045812296ull, 0x4d00000000000000ull,
+    0x9dc5ada82b70b59dull, 0xf020000000000000ull, 0xc5371912364ce305ull, 0x6c28000000000000ull,
+    0xf684df56c3e01bc6ull, 0xc732000000000000ull, 0x9a130b963a6c115cull, 0x3c7f400000000000ull,
+    0xc097ce7bc90715b3ull, 0x4b9f100000000000ull, 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull,
+    0x96769950b50d88f4ull, 0x1314448000000000ull, 0xbc143fa4e250eb31ull, 0x17d955a000000000ull,
+    0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull, 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull,
+    0xb7abc627050305adull, 0xf14a3d9e40000000ull, 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull,
+    0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull, 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull,
+    0xe0352f62a19e306eull, 0xd50b2037ad200000ull, 0x8c213d9da502de45ull, 0x4526f422cc340000ull,
+    0xaf298d050e4395d6ull, 0x9670b12b7f410000ull, 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull,
+    0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull, 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull,
+    0xd5d238a4abe98068ull, 0x72a4904598d6d880ull, 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull,
+    0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull, 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull,
+    0x82818f1281ed449full, 0xbff8f10e7a8921a4ull, 0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull,
+    0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull, 0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull,
+    0x9f4f2726179a2245ull, 0x01d762422c946590ull, 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull,
+    0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull, 0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full,
+    0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull, 0xf316271c7fc3908aull, 0x8bef464e3945ef7aull,
+    0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull, 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull,
+    0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull, 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull,
+    0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull, 0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull,
+    0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull, 0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull,
+    0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull, 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull,
+    0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull, 0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull,
+    0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull, 0xacb92ed9397bf996ull, 0x49c2c37f07965404ull,
+    0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull, 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull,
+    0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull, 0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull,
+    0x83c7088e1aab65dbull, 0x792667c6da79e0faull, 0xa4b8cab1a1563f52ull, 0x577001b891185938ull,
+    0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull, 0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull,
+    0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull, 0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull,
+    0xfb5878494ace3a5full, 0x04ab48a04065c723ull, 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull,
+    0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull, 0xf5746577930d6500ull, 0xca8f44ec7ee36479ull,
+    0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull, 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull,
+    0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull, 0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull,
+    0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull, 0xea1575143cf97226ull, 0xf52d09d71a3293bdull,
+    0x924d692ca61be758ull, 0x593c2626705f9c56ull, 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull,
+    0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull, 0x8edf98b59a373fecull, 0x4724bd4189bd5eacull,
+    0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull, 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull,
+    0x8b865b215899f46cull, 0xbd79e0d20082ee74ull, 0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull,
+    0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull, 0x884134fe908658b2ull, 0x3109058d147fdcddull,
+    0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull, 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull,
+    0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull, 0xa6539930bf6bff45ull, 0x84db8346b786151cull,
+    0xcfe87f7cef46ff16ull, 0xe612641865679a63ull, 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull,
+    0xa26da3999aef7749ull, 0xe3be5e330f38f09dull, 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull,
+    0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull, 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull,
+    0xc646d63501a1511dull, 0xb281e1fd541501b8ull, 0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull,
+    0x9ae757596946075full, 0x3375788de9b06958ull, 0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull,
+    0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull, 0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull,
+    0xbd176620a501fbffull, 0xb650e5a93bc3d898ull, 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull,
+    0x93ba47c980e98cdfull, 0xc66f336c36b10137ull, 0xb8a8d9bbe123f017ull, 0xb80b0047445d4184ull,
+    0xe6d3102ad96cec1dull, 0xa60dc059157491e5ull, 0x9043ea1ac7e41392ull, 0x87c89837ad68db2full,
+    0xb454e4a179dd1877ull, 0x29babe4598c311fbull, 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67aull,
+    0x8ce2529e2734bb1dull, 0x1899e4a65f58660cull, 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f8full,
+    0xdc21a1171d42645dull, 0x76707543f4fa1f73ull, 0x899504ae72497ebaull, 0x6a06494a791c53a8ull,
+    0xabfa45da0edbde69ull, 0x0487db9d17636892ull, 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b6ull,
+    0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b2ull, 0xa7f26836f282b732ull, 0x8e6cac7768d7141eull,
+    0xd1ef0244af2364ffull, 0x3207d795430cd926ull, 0x8335616aed761f1full, 0x7f44e6bd49e807b8ull,
+    0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a6ull, 0xcd036837130890a1ull, 0x36dba887c37a8c0full,
+    0x802221226be55a64ull, 0xc2494954da2c9789ull, 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6cull,
+    0xc83553c5c8965d3dull, 0x6f92829494e5acc7ull, 0xfa42a8b73abbf48cull, 0xcb772339ba1f17f9ull,
+    0x9c69a97284b578d7ull, 0xff2a760414536efbull, 0xc38413cf25e2d70dull, 0xfef5138519684abaull,
+    0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d69ull, 0x98bf2f79d5993802ull, 0xef2f773ffbd97a61ull,
+    0xbeeefb584aff8603ull, 0xaafb550ffacfd8faull, 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf38ull,
+    0x952ab45cfa97a0b2ull, 0xdd945a747bf26183ull, 0xba756174393d88dfull, 0x94f971119aeef9e4ull,
+    0xe912b9d1478ceb17ull, 0x7a37cd5601aab85dull, 0x91abb422ccb812eeull, 0xac62e055c10ab33aull,
+    0xb616a12b7fe617aaull, 0x577b986b314d6009ull, 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80bull,
+    0x8e41ade9fbebc27dull, 0x14588f13be847307ull, 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc8ull,
+    0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bbull, 0x8aec23d680043beeull, 0x25de7bb9480d5854ull,
+    0xada72ccc20054ae9ull, 0xaf561aa79a10ae6aull, 0xd910f7ff28069da4ull, 0x1b2ba1518094da04ull,
+    0x87aa9aff79042286ull, 0x90fb44d2f05d0842ull, 0xa99541bf57452b28ull, 0x353a1607ac744a53ull,
+    0xd3fa922f2d1675f2ull, 0x42889b8997915ce8ull, 0x847c9b5d7c2e09b7ull, 0x69956135febada11ull,
+    0xa59bc234db398c25ull, 0x43fab9837e699095ull, 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bbull,
+    0x8161afb94b44f57dull, 0x1d1be0eebac278f5ull, 0xa1ba1ba79e1632dcull, 0x6462d92a69731732ull,
+    0xca28a291859bbf93ull, 0x7d7b8f7503cfdcfeull, 0xfcb2cb35e702af78ull, 0x5cda735244c3d43eull,
+    0x9defbf01b061adabull, 0x3a0888136afa64a7ull, 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd0ull,
+    0xf6c69a72a3989f5bull, 0x8aad549e57273d45ull, 0x9a3c2087a63f6399ull, 0x36ac54e2f678864bull,
+    0xc0cb28a98fcf3c7full, 0x84576a1bb416a7ddull, 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d5ull,
+    0x969eb7c47859e743ull, 0x9f644ae5a4b1b325ull, 0xbc4665b596706114ull, 0x873d5d9f0dde1feeull,
+    0xeb57ff22fc0c7959ull, 0xa90cb506d155a7eaull, 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f2ull,
+    0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb2full, 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5faull,
+    0x8fa475791a569d10ull, 0xf96e017d694487bcull, 0xb38d92d760ec4455ull, 0x37c981dcc395a9acull,
+    0xe070f78d3927556aull, 0x85bbe253f47b1417ull, 0x8c469ab843b89562ull, 0x93956d7478ccec8eull,
+    0xaf58416654a6babbull, 0x387ac8d1970027b2ull, 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319eull,
+    0x88fcf317f22241e2ull, 0x441fece3bdf81f03ull, 0xab3c2fddeeaad25aull, 0xd527e81cad7626c3ull,
+    0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b074ull, 0x85c7056562757456ull, 0xf6872d5667844e49ull,
+    0xa738c6bebb12d16cull, 0xb428f8ac016561dbull, 0xd106f86e69d785c7ull, 0xe13336d701beba52ull,
+    0x82a45b450226b39cull, 0xecc0024661173473ull, 0xa34d721642b06084ull, 0x27f002d7f95d0190ull,
+    0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f4ull, 0xff290242c83396ceull, 0x7e67047175a15271ull,
+    0x9f79a169bd203e41ull, 0x0f0062c6e984d386ull, 0xc75809c42c684dd1ull, 0x52c07b78a3e60868ull,
+    0xf92e0c3537826145ull, 0xa7709a56ccdf8a82ull, 0x9bbcc7a142b17ccbull, 0x88a66076400bb691ull,
+    0xc2abf989935ddbfeull, 0x6acff893d00ea435ull, 0xf356f7ebf83552feull, 0x0583f6b8c4124d43ull,
+    0x98165af37b2153deull, 0xc3727a337a8b704aull, 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5cull,
+    0xeda2ee1c7064130cull, 0x1162def06f79df73ull, 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba8ull,
+    0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173692ull, 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0437ull,
+    0x910ab1d4db9914a0ull, 0x1d9c9892400a22a2ull, 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4bull,
+    0xe2a0b5dc971f303aull, 0x2e44ae64840fd61dull, 0x8da471a9de737e24ull, 0x5ceaecfed289e5d2ull,
+    0xb10d8e1456105dadull, 0x7425a83e872c5f47ull, 0xdd50f1996b947518ull, 0xd12f124e28f77719ull,
+    0x8a5296ffe33cc92full, 0x82bd6b70d99aaa6full, 0xace73cbfdc0bfb7bull, 0x636cc64d1001550bull,
+    0xd8210befd30efa5aull, 0x3c47f7e05401aa4eull, 0x8714a775e3e95c78ull, 0x65acfaec34810a71ull,
+    0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0dull, 0xd31045a8341ca07cull, 0x1ede48111209a050ull,
+    0x83ea2b892091e44dull, 0x934aed0aab460432ull, 0xa4e4b66b68b65d60ull, 0xf81da84d5617853full,
+    0xce1de40642e3f4b9ull, 0x36251260ab9d668eull, 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b426019ull,
+    0xa1075a24e4421730ull, 0xb24cf65b8612f81full, 0xc94930ae1d529cfcull, 0xdee033f26797b627ull,
+    0xfb9b7cd9a4a7443cull, 0x169840ef017da3b1ull, 0x9d412e0806e88aa5ull, 0x8e1f289560ee864eull,
+    0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e2ull, 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dbull,
+    0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef29ull, 0xbff610b0cc6edd3full, 0x17fd090a58d32af3ull,
+    0xeff394dcff8a948eull, 0xddfc4b4cef07f5b0ull, 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98eull,
+    0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f1ull, 0xea53df5fd18d5513ull, 0x84c86189216dc5edull,
+    0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb4ull, 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a1ull,
+    0xe4d5e82392a40515ull, 0x0fabaf3feaa5334aull, 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400eull,
+    0xb2c71d5bca9023f8ull, 0x743e20e9ef511012ull, 0xdf78e4b2bd342cf6ull, 0x914da9246b255416ull,
+    0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548eull, 0xae9672aba3d0c320ull, 0xa184ac2473b529b1ull,
+    0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741eull, 0x8865899617fb1871ull, 0x7e2fa67c7a658892ull,
+    0xaa7eebfb9df9de8dull, 0xddbb901b98feeab7ull, 0xd51ea6fa85785631ull, 0x552a74227f3ea565ull,
+    0x8533285c936b35deull, 0xd53a88958f87275full, 0xa67ff273b8460356ull, 0x8a892abaf368f137ull,
+    0xd01fef10a657842cull, 0x2d2b7569b0432d85ull, 0x8213f56a67f6b29bull, 0x9c3b29620e29fc73ull,
+    0xa298f2c501f45f42ull, 0x8349f3ba91b47b8full, 0xcb3f2f7642717713ull, 0x241c70a936219a73ull,
+    0xfe0efb53d30dd4d7ull, 0xed238cd383aa0110ull, 0x9ec95d1463e8a506ull, 0xf4363804324a40aaull,
+    0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d5ull, 0xf81aa16fdc1b81daull, 0xdd94b7868e94050aull,
+    0x9b10a4e5e9913128ull, 0xca7cf2b4191c8326ull, 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f0ull,
+    0xf24a01a73cf2dccfull, 0xbc633b39673c8cecull, 0x976e41088617ca01ull, 0xd5be0503e085d813ull,
+    0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e18ull, 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219eull,
+    0x93e1ab8252f33b45ull, 0xcabb90e5c942b503ull, 0xb8da1662e7b00a17ull, 0x3d6a751f3b936243ull,
+    0xe7109bfba19c0c9dull, 0x0cc512670a783ad4ull, 0x906a617d450187e2ull, 0x27fb2b80668b24c5ull,
+    0xb484f9dc9641e9daull, 0xb1f9f660802dedf6ull, 0xe1a63853bbd26451ull, 0x5e7873f8a0396973ull,
+    0x8d07e33455637eb2ull, 0xdb0b487b6423e1e8ull, 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda62ull,
+    0xdc5c5301c56b75f7ull, 0x7641a140cc7810fbull, 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9dull,
+    0xac2820d9623bf429ull, 0x546345fa9fbdcd44ull, 0xd732290fbacaf133ull, 0xa97c177947ad4095ull,
+    0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485dull, 0xa81f301449ee8c70ull, 0x5c68f256bfff5a74ull,
+    0xd226fc195c6a2f8cull, 0x73832eec6fff3111ull, 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eabull,
+    0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e55ull, 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ebull,
+    0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b3ull, 0xa0555e361951c366ull, 0xd7e105bcc332621full,
+    0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa7ull, 0xfa856334878fc150ull, 0xb14f98f6f0feb951ull,
+    0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d3ull, 0xc3b8358109e84f07ull, 0x0a862f80ec4700c8ull,
+    0xf4a642e14c6262c8ull, 0xcd27bb612758c0faull, 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789cull,
+    0xbf21e44003acdd2cull, 0xe0470a63e6bd56c3ull, 0xeeea5d5004981478ull, 0x1858ccfce06cac74ull,
+    0x95527a5202df0ccbull, 0x0f37801e0c43ebc8ull, 0xbaa718e68396cffdull, 0xd30560258f54e6baull,
+    0xe950df20247c83fdull, 0x47c6b82ef32a2069ull, 0x91d28b7416cdd27eull, 0x4cdc331d57fa5441ull,
+    0xb6472e511c81471dull, 0xe0133fe4adf8e952ull, 0xe3d8f9e563a198e5ull, 0x58180fddd97723a6ull,
+    0x8e679c2f5e44ff8full, 0x570f09eaa7ea7648ull
+};
+
+// cson__mul64 - full product of two 64-bit words
+// @a: first factor
+// @b: second factor
+// @hi: high word of the product
+// Return: low word of the product
+static uint64_t cson__mul64(uint64_t a, uint64_t b, uint64_t *hi) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 r = (unsigned __int128) a*b;
+    *hi = (uint64_t) (r >> 64);
+    return (uint64_t) r;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, hi);
+#else
+    uint64_t a0 = (uint32_t) a, a1 = a >> 32, b0 = (uint32_t) b, b1 = b >> 32;
+    uint64_t p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t) p01 + (uint32_t) p10;
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t) p00;
+#endif
+}
+
+// cson__clz - count leading zero bits
+// @x: non-zero word
+// Return: index of the highest set bit counted from the top
+static unsigned cson__clz(uint64_t x) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return 63 - (unsigned) idx;
+#else
+    return (unsigned) __builtin_clzll(x);
+#endif
+}
+
+// cson__eisel_lemire - round w * 10^q to the nearest double
+// @w: decimal mantissa (non-zero)
+// @q: decimal exponent
+// Note: the product with the truncated power of five is exact enough to
+//       round correctly for every w below 2^64 (Mushtak and Lemire, 2023),
+//       so no fallback is needed, ties go to even
+// Return: positive value, 0 on underflow and infinity on overflow
+static double cson__eisel_lemire(uint64_t w, long q) {
+    uint64_t bits;
+    if (q < CSON__POW5_MIN) {
+        bits = 0;
+    } else if (q > CSON__POW5_MAX) {
+        bits = 0x7ffull << 52;
+    } else {
+        unsigned lz = cson__clz(w);
+        w <<= lz;
+        size_t index = 2*(size_t) (q - CSON__POW5_MIN);
+        uint64_t hi, lo = cson__mul64(w, cson__pow5_128[index], &hi);
+        if ((hi & 0x1ff) == 0x1ff) { // the low word of the power may carry into the top 55 bits
+            uint64_t hi2;
+            cson__mul64(w, cson__pow5_128[index + 1], &hi2);
+            lo += hi2;
+            if (hi2 > lo) hi++;
+        }
+        unsigned upper = (unsigned) (hi >> 63), shift = upper + 9;
+        uint64_t mantissa = hi >> shift;
+        int power2 = (int) (((152170 + 65536)*q) >> 16) + 63 + (int) upper - (int) lz + 1023;
+        if (power2 <= 0) { // subnormal
+            if (1 - power2 >= 64) {
+                mantissa = 0;
+            } else {
+                mantissa >>= 1 - power2;
+                mantissa += mantissa & 1;
+                mantissa >>= 1;
+            }
+            power2 = mantissa < (1ull << 52) ? 0 : 1;
+        } else {
+            // an exact halfway product rounds to even instead of up
+            if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi) {
+                mantissa &= ~1ull;
+            }
+            mantissa += mantissa & 1;
+            mantissa >>= 1;
+            if (mantissa >= (2ull << 52)) {
+                mantissa = 1ull << 52;
+                power2++;
+            }
+            if (power2 >= 0x7ff) {
+                power2 = 0x7ff;
+                mantissa = 0;
+            }
+        }
+        bits = (mantissa & ((1ull << 52) - 1)) | (uint64_t) power2 << 52;
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// significant digits cson__strtod keeps, more than the 767 a double can need
+#define CSON__STRTOD_DIGITS 780
+
+// cson__strtod - correctly rounded strtod on a number token
+// @s: number token text (not NUL-terminated)
+// @len: token length
+// Note: slow path only, for mantissas longer than 19 digits whose rounding
+//       the truncated mantissa can not settle; the digits are copied without
+//       the '.' into a stack buffer, so the locale does not matter, and digits
+//       past CSON__STRTOD_DIGITS become one sticky '1', which rounds the same
+//       since no halfway point between doubles lies inside the cut
+// Return: parsed magnitude, the sign is left to the caller
+static double cson__strtod(const char *s, size_t len) {
+    char buffer[CSON__STRTOD_DIGITS + 32];
+    const char *p = s, *end = s + len;
+    size_t n = 0;
+    long exp10 = 0;
+    bool point = false, sticky = false;
+    if (*p == '-') p++;
+    for (; p < end && (cson__is_digit(*p) || *p == '.'); p++) {
+        if (*p == '.') {
+            point = true;
+        } else if (n == 0 && *p == '0') {
+            if (point) exp10--;
+        } else if (n < CSON__STRTOD_DIGITS) {
+            buffer[n++] = *p;
+            if (point) exp10--;
+        } else {
+            if (!point) exp10++;
+            if (*p != '0') sticky = true;
+        }
+    }
+    if (n == 0) buffer[n++] = '0';
+    if (sticky) {
+        buffer[n++] = '1';
+        exp10--;
+    }
+    if (p < end) { // exponent
+        bool eneg = false;
+        long e = 0;
+        p++;
+        if (*p == '+' || *p == '-') eneg = *p++ == '-';
+        for (; p < end; p++) {
+            if (e < 100000) e = 10*e + (*p - '0');
+        }
+        exp10 += eneg ? -e : e;
+    }
+    snprintf(buffer + n, 32, "e%ld", exp10);
+    return strtod(buffer, NULL);
+}
+
+// cson__parse_number - convert a number token into node value
+// @node: number node to fill
+// @s: number token text (already validated by the lexer)
+// @len: token length
+// Note: integers that fit int64 are kept exactly (CSON_FLAG_INTEGER), other values
+//       with at most 19 significant digits and a small exponent are computed
+//       exactly from the decimal mantissa, the rest go through Eisel-Lemire,
+//       and only a longer mantissa that rounds differently once its 20th
+//       digit is cut falls back to strtod
+static void cson__parse_number(cson_node_t *node, const char *s, size_t len) {
+    const char *p = s, *end = s + len;
+    bool neg = false, exact = true, integer = true;
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    long exp10 = 0;
+
+    if (*p == '-') { neg = true; p++; }
+    for (; p < end && cson__is_digit(*p); p++) {
+        if (digits < 19) {
+            mantissa = 10*mantissa + (unsigned) (*p - '0');
+            if (mantissa) digits++;
+        } else {
+            exp10++;
+            if (*p != '0') exact = false;
+        }
+    }
+    if (p < end && *p == '.') {
+        integer = false;
+        for (p++; p < end && cson__is_digit(*p); p++) {
+            if (digits < 19) {
+                mantissa = 10*mantissa + (unsigned) (*p - '0');
+                if (mantissa) digits++;
+                exp10--;
+            } else if (*p != '0') {
+                exact = false;
+            }
+        }
+    }
+    if (p < end) { // exponent
+        integer = false;
+        bool eneg = false;
+        long e = 0;
+        p++;
+        if (*p == '+' || *p == '-') eneg = *p++ == '-';
+        for (; p < end; p++) {
+            if (e < 100000) e = 10*e + (*p - '0');
+        }
+        exp10 += eneg ? -e : e;
+    }
+
+    if (integer && exp10 == 0 && exact && !(neg && mantissa == 0)) {
+        unsigned long long limit = neg ? (1ull << 63) : (1ull << 63) - 1;
+        if (mantissa <= limit) {
+            node->flags |= CSON_FLAG_INTEGER;
+            node->as.integer = neg ? (int64_t) (0 - mantissa) : (int64_t) mantissa;
+            return;
+        }
+    }
+
+    if (exact && mantissa <= (1ull << 53)) {
+        double value = (double) mantissa;
+        if (mantissa == 0) {
+            node->as.number = neg ? -0.0 : 0.0;
+            return;
+        }
+        if (exp10 > 22 && exp10 <= 22 + 15) {
+            // move the surplus exponent into the mantissa while it stays exact
+            long shift = exp10 - 22;
+            unsigned long long scaled = mantissa;
+            while (shift > 0 && scaled <= (1ull << 53)/10) { scaled *= 10; shift--; }
+            if (shift == 0) {
+                value = (double) scaled;
+                exp10 = 22;
+            }
+        }
+        if (exp10 >= 0 && exp10 <= 22) {
+            value *= cson__pow10[exp10];
+            node->as.number = neg ? -value : value;
+            return;
+        }
+        if (exp10 < 0 && exp10 >= -22) {
+            value /= cson__pow10[-exp10];
+            node->as.number = neg ? -value : value;
+            return;
+        }
+    }
+
+    double value = cson__eisel_lemire(mantissa, exp10);
+    if (!exact && cson__eisel_lemire(mantissa + 1, exp10) != value) value = cson__strtod(s, len);
+    node->as.number = neg ? -value : value;
+}
+
+// cson__make_scalar - build a scalar node from its token
+// @p: pointer to parser
+// @token: null, boolean, number or string token
+// Note: abort on any other token
+// Return: value node without key yet
+static cson_node_t cson__make_scalar(cson__parser_t *p, cson_token_t token) {
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+
+    switch (token.kind) {
+    case CSON_TK_NULL:
+        node.kind = CSON_NULL;
+        break;
+    case CSON_TK_NUMBER:
+        node.kind = CSON_NUMBER;
+        cson__parse_number(&node, token.start, token.len);
+        break;
+    case CSON_TK_TRUE:
+        node.kind = CSON_BOOLEAN;
+        node.as.boolean = true;
+        break;
+    case CSON_TK_FALSE:
+        node.kind = CSON_BOOLEAN;
+        node.as.boolean = false;
+        break;
+    case CSON_TK_STRING:
+        node.kind = CSON_STRING;
+        if (token.len < sizeof(node.as.small) && !p->insitu) {
+            size_t len = token.len;
+            if (token.escaped) len = cson__unescape(node.as.small, token.start, token.len);
+            else memcpy(node.as.small, token.start, token.len);
+            node.as.small[len] = '\0';
+            node.flags |= CSON_FLAG_INLINE;
+        } else {
+            node.as.string = cson__parser_string(p, token);
+        }
+        break;
+    default:
+        if (!p->lex.recover) cson__fatal("unexpected token at '%.*s'", (int) token.len, token.start);
+        cson__parser_fail(p, token);
+        node.kind = CSON_NULL;
+    }
+
+    if (p->arena) node.flags |= CSON_FLAG_ARENA;
+    CSON__STAT_ADD(nodes, 1);
+    return node;
+}
+
+// cson__make_key - build the key of a pair from its token
+// @p: pointer to parser
+// @token: string token
+// @flags: node flags, CSON_FLAG_KEY_INTERNED is added for a canonical key
+// Return: interned key if the parser has a key table with room, otherwise a copy
+static char *cson__make_key(cson__parser_t *p, cson_token_t token, unsigned int *flags) {
+    char *key = NULL;
+    if (p->keys && token.escaped) {
+        char buf[CSON__TEXT_BUF];
+        size_t len;
+        char *text = cson__text_decode(token, buf, &len);
+        key = cson__keytab_intern(p->keys, text, len);
+        if (text != buf) cson__free(text);
+    } else if (p->keys) {
+        key = cson__keytab_intern(p->keys, token.start, token.len);
+    }
+    if (key) {
+        *flags |= CSON_FLAG_KEY_INTERNED;
+        return key;
+    }
+    return cson__parser_string(p, token);
+}
+
+// cson__parse_lazy - record a nested container without parsing it
+// @p: pointer to lazy parser, the lookahead is '{' or '['
+// Return: container node with CSON_FLAG_LAZY, without key yet
+static cson_node_t cson__parse_lazy(cson__parser_t *p) {
+    const char *start = p->look.start;
+    const char *end = cson__skip_container(start, p->lex.end);
+    if (!end) cson__fatal("unterminated container at '%.*s'", 16, start);
+
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+    node.kind = p->look.kind == CSON_TK_LCURLY ? CSON_OBJECT : CSON_ARRAY;
+    node.flags = CSON_FLAG_ARENA | CSON_FLAG_LAZY;
+    node.as.lazy = (cson_lazy_t *) cson__arena_alloc(p->arena, sizeof(cson_lazy_t));
+    node.as.lazy->start = start;
+    node.as.lazy->len = (size_t) (end - start);
+    node.as.lazy->doc = p->lazy;
+
+    p->lex.current = end;
+    cson__advance(p);
+    CSON__STAT_ADD(nodes, 1);
+    return node;
+}
+
+// cson__parser_enter - count one more open container
+// @p: pointer to parser
+// Note: abort past CSON_MAX_DEPTH, a recovering parser fails instead
+// Return: false if the limit was hit
+static bool cson__parser_enter(cson__parser_t *p) {
+    if (++p->depth <= CSON_MAX_DEPTH) {
+        CSON__STAT_PEAK(p->depth);
+        return true;
+    }
+    if (!p->lex.recover) cson__fatal("nesting deeper than CSON_MAX_DEPTH (%d)", CSON_MAX_DEPTH);
+    p->look = cson__make_error(&p->lex, CSON_ERROR_DEPTH, p->look.start);
+    return false;
+}
+
+// cson__parser_open - open a container on the scratch stack
+// @p: pointer to parser, the lookahead is '{' or '['
+// @key: key of the container (Nullable)
+// @flags: flags of key
+// Note: a placeholder node keeps the key and the index of the enclosing
+//       placeholder, the children are pushed after it
+static void cson__parser_open(cson__parser_t *p, char *key, unsigned int flags) {
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+    node.kind = p->look.kind == CSON_TK_LCURLY ? CSON_OBJECT : CSON_ARRAY;
+    node.key = key;
+    node.flags = flags;
+    node.as.integer = (int64_t) p->open;
+    p->open = p->stack.len;
+    cson__parser_push(p, node);
+    if (cson__parser_enter(p)) cson__advance(p);
+}
+
+// cson__parse_container - parse an object or array
+// @p: pointer to parser, the lookahead is '{' or '['
+// Note: nested containers take scratch stack slots instead of call frames,
+//       so only CSON_MAX_DEPTH bounds the nesting
+// Return: container node without key yet
+static cson_node_t cson__parse_container(cson__parser_t *p) {
+    enum { FIRST, MEMBER, NEXT } state = FIRST; // member or close, member, ',' or close
+    size_t outer = p->open, floor = p->stack.len;
+    bool object = p->look.kind == CSON_TK_LCURLY;
+    cson__parser_open(p, NULL, 0);
+
+    while (1) {
+        cson_token_kind_t close = object ? CSON_TK_RCURLY : CSON_TK_RSQUARE;
+        if (state == NEXT && p->look.kind == CSON_TK_COMMA) {
+            cson__advance(p);
+            state = MEMBER;
+            continue;
+        }
+        if (state == NEXT || (state == FIRST && p->look.kind == close)) {
+            cson__expect(p, close);
+            size_t open = p->open;
+            cson_node_t holder = p->stack.items[open];
+            cson_node_t node = cson__parser_close(p, holder.kind, open + 1);
+            node.key = holder.key;
+            node.flags |= holder.flags;
+            p->depth--;
+            if (open == floor) {
+                p->stack.len = floor;
+                p->open = outer;
+                return node;
+            }
+            p->stack.items[open] = node;
+            p->open = (size_t) holder.as.integer;
+            object = p->stack.items[p->open].kind == CSON_OBJECT;
+            state = NEXT;
+            continue;
+        }
+
+        char *key = NULL;
+        unsigned int flags = 0;
+        if (object) {
+            cson_token_t token = cson__expect(p, CSON_TK_STRING);
+            cson__expect(p, CSON_TK_COLON);
+            key = cson__make_key(p, token, &flags);
+        }
+        cson_node_t node;
+        if (p->look.kind == CSON_TK_LCURLY || p->look.kind == CSON_TK_LSQUARE) {
+            if (!p->lazy) {
+                object = p->look.kind == CSON_TK_LCURLY;
+                cson__parser_open(p, key, flags);
+                state = FIRST;
+                continue;
+            }
+            node = cson__parse_lazy(p);
+        } else {
+            node = cson__make_scalar(p, cson__advance(p));
+        }
+        node.key = key;
+        node.flags |= flags;
+        cson__parser_push(p, node);
+        state = NEXT;
+    }
+}
+
+// cson__materialize - parse the children of a lazy container
+// @node: container node (cast from const by the readers)
+// Note: the children are parsed one level deep into the document arena,
+//       nested containers among them stay lazy
+static void cson__materialize(cson_node_t *node) {
+    cson_doc_t *doc = node->as.lazy->doc;
+    cson__parser_t p;
+    memset(&p, 0, sizeof(p));
+    p.lex.start = node->as.lazy->start;
+    p.lex.current = node->as.lazy->start;
+    p.lex.end = node->as.lazy->start + node->as.lazy->len;
+    p.arena = &doc->arena;
+    p.keys = doc->keys;
+    p.lazy = doc;
+
+    cson__advance(&p);
+    cson_node_t full = cson__parse_container(&p);
+    cson__free(p.stack.items);
+    full.key = node->key;
+    full.flags |= node->flags & CSON_FLAG_KEY_INTERNED;
+    *node = full;
+}
+
+// cson__parser_init - prepare a parser over a buffer
+// @p: pointer to parser
+// @buffer: json text
+// @len: text length
+static void cson__parser_init(cson__parser_t *p, const char *buffer, size_t len) {
+    memset(p, 0, sizeof(*p));
+    p->lex.start = buffer;
+    p->lex.current = buffer;
+    p->lex.end = buffer + len;
+}
+
+// cson__parse_root - parse the top level object
+// @p: pointer to initialized parser
+// Note: the scratch stack of p is released, a recovering parser that met an
+//       error still returns the partial tree so it can be freed
+// Return: root node
+static cson_node_t cson__parse_root(cson__parser_t *p) {
+    CSON__STAT_CLOCK(start);
+    cson__advance(p);
+    if (p->look.kind != CSON_TK_LCURLY) {
+        if (!p->lex.recover) cson__fatal("expect %d, but got %d at '%.*s'", CSON_TK_LCURLY,
+                                         p->look.kind, (int) p->look.len, p->look.start);
+        cson__parser_fail(p, p->look);
+    }
+    cson_node_t root = cson__parse_container(p);
+    if (p->arena) root.flags |= CSON_FLAG_ARENA;
+    cson__free(p->stack.items);
+    p->stack.items = NULL;
+    CSON__STAT_ADD(load_seconds, CSON__STAT_SINCE(start));
+    return root;
+}
+
+// cson__create_node - create a node without value
+// @kind: node type
+// @key: member key (Nullable)
+// Return: node with zeroed value (always valid)
+static cson_node_t cson__create_node(cson_node_kind_t kind, const char *key) {
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+    node.kind = kind;
+    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
+    CSON__STAT_ADD(nodes, 1);
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_object(const char *key) {
+    return cson__create_node(CSON_OBJECT, key);
+}
+
+CSONDEF cson_node_t cson_create_array(const char *key) {
+    return cson__create_node(CSON_ARRAY, key);
+}
+
+CSONDEF cson_node_t cson_create_number(const char *key, double value) {
+    cson_node_t node = cson__create_node(CSON_NUMBER, key);
+    node.as.number = value;
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_int64(const char *key, int64_t value) {
+    cson_node_t node = cson__create_node(CSON_NUMBER, key);
+    node.flags |= CSON_FLAG_INTEGER;
+    node.as.integer = value;
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_boolean(const char *key, bool value) {
+    cson_node_t node = cson__create_node(CSON_BOOLEAN, key);
+    node.as.boolean = value;
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_string(const char *key, const char *value) {
+    cson_node_t node = cson__create_node(CSON_STRING, key);
+    size_t len = value ? strlen(value) : 0;
+    if (value && len < sizeof(node.as.small)) {
+        memcpy(node.as.small, value, len + 1);
+        node.flags |= CSON_FLAG_INLINE;
+    } else {
+        node.as.string = cson__strndup(value, len);
+    }
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_null(const char *key) {
+    return cson__create_node(CSON_NULL, key);
+}
+
+CSONDEF cson_node_t cson_create_string_owned(char *key, char *value) {
+    cson_node_t node = cson__create_node(CSON_STRING, NULL);
+    node.key = key;
+    node.as.string = value;
+    return node;
+}
+
+CSONDEF cson_node_t cson_create_string_ref(const char *key, const char *value) {
+    cson_node_t node = cson__create_node(CSON_STRING, NULL);
+    node.flags |= CSON_FLAG_BORROWED;
+    node.key = (char *) key;
+    node.as.string = (char *) value;
+    return node;
+}
+
+CSONDEF cson_node_t cson_load_buffer(const char *buffer) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, strlen(buffer));
+    return cson__parse_root(&p);
+}
+
+CSONDEF cson_node_t cson_load_file(const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson__parser_t p;
+    cson__parser_init(&p, file.data, file.len);
+    cson_node_t root = cson__parse_root(&p);
+    cson__file_close(&file);
+    return root;
+}
+
+// cson__error_at - fill an error report
+// @err: report (Nullable)
+// @code: error code
+// @buffer: start of the json text
+// @at: offending text inside buffer (NULL for errors without position)
+// Note: the line and column are only counted here, after the parse failed
+static void cson__error_at(cson_error_t *err, cson_error_code_t code, const char *buffer, const char *at) {
+    if (!err) return;
+    memset(err, 0, sizeof(*err));
+    err->code = code;
+    if (code == CSON_OK || !at) return;
+    err->offset = (size_t) (at - buffer);
+    err->line = 1;
+    const char *line = buffer;
+    for (const char *nl; (nl = (const char *) memchr(line, '\n', (size_t) (at - line))); line = nl + 1) {
+        err->line++;
+    }
+    err->column = (size_t) (at - line) + 1;
+}
+
+// cson__parser_check - finish a recovering parse
+// @p: pointer to recovering parser that parsed the root
+// @buffer: start of the json text
+// @err: report (Nullable)
+// Note: text left after the root object is an error
+// Return: true if no error was met
+static bool cson__parser_check(cson__parser_t *p, const char *buffer, cson_error_t *err) {
+    if (p->lex.error == CSON_OK && p->look.kind != CSON_TK_EOF) {
+        cson__make_error(&p->lex, CSON_ERROR_TRAILING, p->look.start);
+    }
+    cson__error_at(err, p->lex.error, buffer, p->lex.error_at);
+    return p->lex.error == CSON_OK;
+}
+
+CSONDEF bool cson_try_load_buffer(const char *buffer, size_t len, cson_node_t *root, cson_error_t *err) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.lex.recover = true;
+    *root = cson__parse_root(&p);
+    if (cson__parser_check(&p, buffer, err)) return true;
+    cson_free(root);
+    memset(root, 0, sizeof(*root));
+    return false;
+}
+
+CSONDEF bool cson_try_load_file(const char *path, cson_node_t *root, cson_error_t *err) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) {
+        cson__error_at(err, CSON_ERROR_FILE, NULL, NULL);
+        memset(root, 0, sizeof(*root));
+        return false;
+    }
+    bool ok = cson_try_load_buffer(file.data, file.len, root, err);
+    cson__file_close(&file);
+    return ok;
+}
+
+CSONDEF bool cson_validate(const char *buffer, size_t len, cson_error_t *err) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.lex.recover = true;
+
+    // kinds of the open containers
+    unsigned char local[256];
+    unsigned char *stack = local;
+    size_t depth = 0, cap = sizeof(local);
+    bool value = true; // a value comes next, otherwise ',' or a closing token
+
+    cson__advance(&p);
+    if (p.look.kind != CSON_TK_LCURLY) cson__parser_fail(&p, p.look);
+    while (p.lex.error == CSON_OK) {
+        cson_token_kind_t kind = p.look.kind;
+        if (value) {
+            if (kind == CSON_TK_LCURLY || kind == CSON_TK_LSQUARE) {
+                if (depth == CSON_MAX_DEPTH) {
+                    p.look = cson__make_error(&p.lex, CSON_ERROR_DEPTH, p.look.start);
+                    break;
+                }
+                if (depth == cap) {
+                    cap *= 2;
+                    if (stack == local) {
+                        stack = (unsigned char *) cson__malloc(cap);
+                        memcpy(stack, local, depth);
+                    } else {
+                        stack = (unsigned char *) cson__realloc(stack, cap);
+                    }
+                }
+                stack[depth++] = (unsigned char) kind;
+                cson__advance(&p);
+                if (p.look.kind == (kind == CSON_TK_LCURLY ? CSON_TK_RCURLY : CSON_TK_RSQUARE)) {
+                    cson__advance(&p);
+                    depth--;
+                    value = false;
+                } else if (kind == CSON_TK_LCURLY) {
+                    cson__expect(&p, CSON_TK_STRING);
+                    cson__expect(&p, CSON_TK_COLON);
+                }
+            } else if (kind == CSON_TK_STRING || kind == CSON_TK_NUMBER || kind == CSON_TK_TRUE ||
+                       kind == CSON_TK_FALSE || kind == CSON_TK_NULL) {
+                cson__advance(&p);
+                value = false;
+            } else {
+                cson__parser_fail(&p, p.look);
+            }
+            continue;
+        }
+
+        if (depth == 0) break;
+        bool object = stack[depth - 1] == CSON_TK_LCURLY;
+        if (kind == CSON_TK_COMMA) {
+            cson__advance(&p);
+            if (object) {
+                cson__expect(&p, CSON_TK_STRING);
+                cson__expect(&p, CSON_TK_COLON);
+            }
+            value = true;
+        } else if (kind == (object ? CSON_TK_RCURLY : CSON_TK_RSQUARE)) {
+            cson__advance(&p);
+            depth--;
+        } else {
+            cson__parser_fail(&p, p.look);
+        }
+    }
+
+    if (stack != local) cson__free(stack);
+    return cson__parser_check(&p, buffer, err);
+}
+
+CSONDEF const char *cson_error_string(cson_error_code_t code) {
+    switch (code) {
+    case CSON_OK: return "no error";
+    case CSON_ERROR_FILE: return "file is empty or cannot be read";
+    case CSON_ERROR_CHARACTER: return "unexpected character";
+    case CSON_ERROR_STRING: return "unterminated string";
+    case CSON_ERROR_NUMBER: return "invalid number";
+    case CSON_ERROR_LITERAL: return "unknown literal";
+    case CSON_ERROR_SYNTAX: return "unexpected token";
+    case CSON_ERROR_EOF: return "unexpected end of json text";
+    case CSON_ERROR_TRAILING: return "unexpected text after the root object";
+    case CSON_ERROR_DEPTH: return "containers nested too deep";
+    case CSON_ERROR_ESCAPE: return "invalid escape sequence";
+    case CSON_ERROR_UTF8: return "invalid utf-8 in string";
+    }
+    return "unknown error";
+}
+
+// cson__doc_reset - discard the previous tree of doc
+// @doc: document
+static void cson__doc_reset(cson_doc_t *doc) {
+    cson__arena_reset(&doc->arena);
+    if (doc->source) {
+        cson__file_t file;
+        file.data = doc->source;
+        file.len = doc->source_len;
+        file.mapped = doc->source_mapped;
+        cson__file_close(&file);
+    }
+    doc->source = NULL;
+    doc->source_len = 0;
+    doc->source_mapped = false;
+}
+
+// cson__doc_parse - parse buffer into doc
+// @doc: document
+// @buffer: json text
+// @len: text length
+// @insitu: keep keys and strings inside buffer
+// @lazy: leave nested containers unparsed
+static void cson__doc_parse(cson_doc_t *doc, const char *buffer, size_t len, bool insitu, bool lazy) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.arena = &doc->arena;
+    p.insitu = insitu;
+    p.keys = doc->keys;
+    p.lazy = lazy ? doc : NULL;
+    doc->root = cson__parse_root(&p);
+}
+
+CSONDEF cson_node_t *cson_load_buffer_arena(cson_doc_t *doc, const char *buffer) {
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, buffer, strlen(buffer), false, false);
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_load_file_arena(cson_doc_t *doc, const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, file.data, file.len, false, false);
+    cson__file_close(&file);
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_load_buffer_insitu(cson_doc_t *doc, char *buffer) {
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, buffer, strlen(buffer), true, false);
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_load_file_insitu(cson_doc_t *doc, const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, true)) cson__fatal("empty file or error occurs when reading file");
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, file.data, file.len, true, false);
+    doc->source = file.data;
+    doc->source_len = file.len;
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_load_buffer_lazy(cson_doc_t *doc, const char *buffer) {
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, buffer, strlen(buffer), false, true);
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_load_file_lazy(cson_doc_t *doc, const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson__doc_reset(doc);
+    cson__doc_parse(doc, file.data, file.len, false, true);
+    doc->source = file.data;
+    doc->source_len = file.len;
+    doc->source_mapped = file.mapped;
+    return &doc->root;
+}
+
+CSONDEF cson_node_t *cson_try_load_buffer_arena(cson_doc_t *doc, const char *buffer, size_t len,
+                                              cson_error_t *err) {
+    cson__doc_reset(doc);
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.arena = &doc->arena;
+    p.keys = doc->keys;
+    p.lex.recover = true;
+    doc->root = cson__parse_root(&p);
+    if (cson__parser_check(&p, buffer, err)) return &doc->root;
+    cson__arena_reset(&doc->arena);
+    memset(&doc->root, 0, sizeof(doc->root));
+    return NULL;
+}
+
+CSONDEF void cson_doc_free(cson_doc_t *doc) {
+    if (!doc) return;
+    cson__doc_reset(doc);
+    cson__arena_free(&doc->arena);
+    memset(&doc->root, 0, sizeof(doc->root));
+}
+
+// push parser states, named after the token expected next
+enum {
+    CSON__PUSH_ROOT,        // '{' of the root object
+    CSON__PUSH_FIRST_KEY,   // key or '}' right after '{'
+    CSON__PUSH_KEY,         // key after ','
+    CSON__PUSH_COLON,       // ':' after a key
+    CSON__PUSH_FIRST_VALUE, // value or ']' right after '['
+    CSON__PUSH_VALUE,       // value after ':' or ','
+    CSON__PUSH_NEXT,        // ',' or the end of the innermost container
+    CSON__PUSH_DONE         // root object is complete
+};
+
+// cson__push_open - enter a container
+// @p: pointer to push parser
+// @q: parser owning the scratch stack
+// @kind: container type
+// Note: the pending key becomes the key of the container
+static void cson__push_open(cson_parser_t *p, cson__parser_t *q, cson_node_kind_t kind) {
+    if (p->depth >= CSON_MAX_DEPTH) cson__fatal("nesting deeper than CSON_MAX_DEPTH (%d)", CSON_MAX_DEPTH);
+    if (p->depth + 1 > p->frames_cap) {
+        p->frames_cap = p->frames_cap < 16 ? 16 : 2*p->frames_cap;
+        p->frames = (cson_push_frame_t *) cson__realloc(p->frames, sizeof(cson_push_frame_t)*p->frames_cap);
+    }
+    cson_push_frame_t *frame = &p->frames[p->depth++];
+    CSON__STAT_PEAK(p->depth);
+    frame->kind = kind;
+    frame->key_flags = p->key_flags;
+    frame->key = p->key;
+    frame->base = q->stack.len;
+    p->key = NULL;
+    p->key_flags = 0;
+    p->state = kind == CSON_OBJECT ? CSON__PUSH_FIRST_KEY : CSON__PUSH_FIRST_VALUE;
+}
+
+// cson__push_close - leave the innermost container
+// @p: pointer to push parser
+// @q: parser owning the scratch stack
+static void cson__push_close(cson_parser_t *p, cson__parser_t *q) {
+    cson_push_frame_t *frame = &p->frames[--p->depth];
+    cson_node_t node = cson__parser_close(q, frame->kind, frame->base);
+    node.key = frame->key;
+    node.flags |= frame->key_flags;
+    if (p->depth == 0) {
+        p->root = node;
+        p->state = CSON__PUSH_DONE;
+        return;
+    }
+    cson__parser_push(q, node);
+    p->state = CSON__PUSH_NEXT;
+}
+
+// cson__push_token - advance the push parser by one complete token
+// @p: pointer to push parser
+// @q: parser owning the scratch stack
+// @token: next token
+// Note: abort if the token is unexpected in the current state
+static void cson__push_token(cson_parser_t *p, cson__parser_t *q, cson_token_t token) {
+    switch (p->state) {
+    case CSON__PUSH_ROOT:
+        if (token.kind != CSON_TK_LCURLY) break;
+        cson__push_open(p, q, CSON_OBJECT);
+        return;
+
+    case CSON__PUSH_FIRST_KEY:
+        if (token.kind == CSON_TK_RCURLY) {
+            cson__push_close(p, q);
+            return;
+        }
+        // fallthrough
+    case CSON__PUSH_KEY:
+        if (token.kind != CSON_TK_STRING) break;
+        p->key = cson__make_key(q, token, &p->key_flags);
+        p->state = CSON__PUSH_COLON;
+        return;
+
+    case CSON__PUSH_COLON:
+        if (token.kind != CSON_TK_COLON) break;
+        p->state = CSON__PUSH_VALUE;
+        return;
+
+    case CSON__PUSH_FIRST_VALUE:
+        if (token.kind == CSON_TK_RSQUARE) {
+            cson__push_close(p, q);
+            return;
+        }
+        // fallthrough
+    case CSON__PUSH_VALUE: {
+        if (token.kind == CSON_TK_LCURLY || token.kind == CSON_TK_LSQUARE) {
+            cson__push_open(p, q, token.kind == CSON_TK_LCURLY ? CSON_OBJECT : CSON_ARRAY);
+            return;
+        }
+        cson_node_t node = cson__make_scalar(q, token);
+        node.key = p->key;
+        node.flags |= p->key_flags;
+        p->key = NULL;
+        p->key_flags = 0;
+        cson__parser_push(q, node);
+        p->state = CSON__PUSH_NEXT;
+        return;
+    }
+
+    case CSON__PUSH_NEXT: {
+        cson_node_kind_t kind = p->frames[p->depth - 1].kind;
+        if (token.kind == CSON_TK_COMMA) {
+            p->state = kind == CSON_OBJECT ? CSON__PUSH_KEY : CSON__PUSH_VALUE;
+            return;
+        }
+        if (token.kind == (kind == CSON_OBJECT ? CSON_TK_RCURLY : CSON_TK_RSQUARE)) {
+            cson__push_close(p, q);
+            return;
+        }
+    } break;
+
+    default:
+        break;
+    }
+    if (token.kind == CSON_TK_EOF) cson__fatal("unexpected end of json text");
+    cson__fatal("unexpected token at '%.*s'", (int) token.len, token.start);
+}
+
+// cson__carry_append - copy more bytes of the cut token
+// @p: pointer to push parser
+// @s: bytes
+// @n: byte count
+static void cson__carry_append(cson_parser_t *p, const char *s, size_t n) {
+    if (p->carry_len + n > p->carry_cap) {
+        size_t cap = p->carry_cap < 64 ? 64 : p->carry_cap;
+        while (cap < p->carry_len + n) cap *= 2;
+        p->carry = (char *) cson__realloc(p->carry, cap);
+        p->carry_cap = cap;
+    }
+    memcpy(p->carry + p->carry_len, s, n);
+    p->carry_len += n;
+}
+
+// cson__carry_tail - find where the cut token ends in the next chunk
+// @p: pointer to push parser with a non-empty carry
+// @chunk: next chunk
+// @len: chunk length
+// @n: output byte count of chunk belonging to the token
+// Note: a string continues up to its closing '"' (a trailing odd run of '\\'
+//       in the carry escapes the first byte), numbers and literals up to the
+//       first byte that cannot be part of them
+// Return: true if the token is complete
+static bool cson__carry_tail(const cson_parser_t *p, const char *chunk, size_t len, size_t *n) {
+    const char *end = chunk + len;
+    if (p->carry[0] == '"') {
+        size_t slashes = 0;
+        while (slashes + 1 < p->carry_len && p->carry[p->carry_len - 1 - slashes] == '\\') slashes++;
+        const char *from = chunk + (slashes % 2);
+        if (from > end) from = end;
+        const char *close = cson__scan_string(from, end);
+        *n = close < end ? (size_t) (close + 1 - chunk) : len;
+        return close < end;
+    }
+
+    const char *s = chunk;
+    if (p->carry[0] == '-' || cson__is_digit(p->carry[0])) {
+        while (s < end && (cson__is_digit(*s) || *s == '.' || *s == 'e' || *s == 'E' ||
+                           *s == '+' || *s == '-')) s++;
+    } else {
+        while (s < end && *s >= 'a' && *s <= 'z') s++;
+    }
+    *n = (size_t) (s - chunk);
+    return s < end;
+}
+
+// cson__carry_flush - feed the completed cut token to the push parser
+// @p: pointer to push parser
+// @q: parser owning the scratch stack
+static void cson__carry_flush(cson_parser_t *p, cson__parser_t *q) {
+    cson_lexer_t lex;
+    memset(&lex, 0, sizeof(lex));
+    lex.start = p->carry;
+    lex.current = p->carry;
+    lex.end = p->carry + p->carry_len;
+    cson__push_token(p, q, cson__get_next_token(&lex));
+    p->carry_len = 0;
+}
+
+CSONDEF void cson_parser_init(cson_parser_t *p) {
+    memset(p, 0, sizeof(*p));
+}
+
+CSONDEF void cson_parser_feed(cson_parser_t *p, const char *chunk, size_t len) {
+    if (p->state == CSON__PUSH_DONE || len == 0) return;
+    cson__parser_t q;
+    cson__parser_init(&q, chunk, len);
+    q.lex.partial = true;
+    q.keys = p->keys;
+    q.stack = p->stack;
+
+    if (p->carry_len > 0) {
+        size_t n;
+        bool complete = cson__carry_tail(p, chunk, len, &n);
+        cson__carry_append(p, chunk, n);
+        if (complete) {
+            cson__carry_flush(p, &q);
+            q.lex.current = chunk + n;
+        } else {
+            q.lex.current = q.lex.end;
+        }
+    }
+
+    while (p->state != CSON__PUSH_DONE) {
+        cson_token_t token = cson__get_next_token(&q.lex);
+        if (token.kind == CSON_TK_EOF) {
+            // keep a token cut by the end of chunk for the next call
+            if (token.start < q.lex.end) {
+                cson__carry_append(p, token.start, (size_t) (q.lex.end - token.start));
+            }
+            break;
+        }
+        cson__push_token(p, &q, token);
+    }
+    p->stack = q.stack;
+}
+
+CSONDEF bool cson_parser_done(const cson_parser_t *p) {
+    return p->state == CSON__PUSH_DONE;
+}
+
+CSONDEF cson_node_t cson_parser_finish(cson_parser_t *p) {
+    if (p->carry_len > 0 && p->state != CSON__PUSH_DONE) {
+        cson__parser_t q;
+        memset(&q, 0, sizeof(q));
+        q.keys = p->keys;
+        q.stack = p->stack;
+        cson__carry_flush(p, &q);
+        p->stack = q.stack;
+    }
+    if (p->state != CSON__PUSH_DONE) cson__fatal("unexpected end of json text");
+
+    cson_node_t root = p->root;
+    cson_keytab_t *keys = p->keys;
+    cson__free(p->stack.items);
+    cson__free(p->frames);
+    cson__free(p->carry);
+    cson_parser_init(p);
+    p->keys = keys;
+    return root;
+}
+
+CSONDEF void cson_parser_free(cson_parser_t *p) {
+    if (!p) return;
+    for (size_t i = 0; i < p->stack.len; i++) cson_free(&p->stack.items[i]);
+    for (size_t i = 0; i < p->depth; i++) {
+        if (!(p->frames[i].key_flags & CSON_FLAG_KEY_INTERNED)) cson__free(p->frames[i].key);
+    }
+    if (!(p->key_flags & CSON_FLAG_KEY_INTERNED)) cson__free(p->key);
+    if (p->state == CSON__PUSH_DONE) cson_free(&p->root);
+    cson__free(p->stack.items);
+    cson__free(p->frames);
+    cson__free(p->carry);
+    cson_parser_init(p);
+}
+
+// cson__emit - call an optional callback
+// @h: handler
+// @fn: callback member
+// Return: false if the callback asked to stop
+#define cson__emit(h, fn, ...) (!(h)->fn || (h)->fn(__VA_ARGS__))
+
+// cson__sax_text - pass the decoded text of a key or string to a callback
+// @fn: key or string callback (Nullable)
+// @part: callback of the leading pieces (Nullable)
+// @user: user pointer
+// @token: string token
+// Note: text without escapes is passed where it lies in the input, escaped
+//       text is decoded on the stack in pieces of at most CSON__TEXT_BUF
+//       bytes, a piece never cuts an escape or a utf-8 sequence; without
+//       part, text longer than one piece is decoded whole instead
+// Return: false if the callback asked to stop
+static bool cson__sax_text(bool (*fn)(void *, const char *, size_t), bool (*part)(void *, const char *, size_t),
+                           void *user, cson_token_t token) {
+    if (!fn) return true;
+    if (!token.escaped) return fn(user, token.start, token.len);
+    // an escape decodes to 4 bytes at most, so one that starts below the
+    // limit still fits
+    const size_t limit = CSON__TEXT_BUF - 4;
+    // the source of a piece may be longer than the buffer, the vector stores
+    // of cson__unescape then run up to 32 bytes past the decoded text
+    char buf[CSON__TEXT_BUF + 32];
+    const char *s = token.start, *end = token.start + token.len;
+    while (1) {
+        const char *q = s;
+        size_t n = 0; // decoded size of s..q
+        while (n < limit) {
+            const char *bs = (const char *) memchr(q, '\\', (size_t) (end - q));
+            size_t run = (size_t) ((bs ? bs : end) - q);
+            if (n + run > limit) {
+                q += limit - n;
+                while (((unsigned char) *q & 0xc0) == 0x80) q--;
+                break;
+            }
+            n += run;
+            if (!bs) {
+                q = end;
+                break;
+            }
+            if (bs[1] != 'u') {
+                q = bs + 2;
+                n += 1;
+                continue;
+            }
+            uint32_t cp = cson__hex4_checked(bs + 2);
+            if ((cp & 0xfc00) == 0xd800) q = bs + 12, n += 4;
+            else q = bs + 6, n += cp < 0x80 ? 1 : cp < 0x800 ? 2 : 3;
+        }
+        if (q != end && !part) break;
+        size_t len = cson__unescape(buf, s, (size_t) (q - s));
+        if (q == end) return fn(user, buf, len);
+        if (!part(user, buf, len)) return false;
+        s = q;
+    }
+
+    size_t len;
+    char *text = cson__text_decode(token, buf, &len);
+    bool go = fn(user, text, len);
+    if (text != buf) cson__free(text);
+    return go;
+}
+
+// cson__sax_scalar - parse a scalar value into callbacks
+// @p: pointer to parser
+// @h: handler
+// @user: user pointer
+// Return: false if a callback asked to stop
+static bool cson__sax_scalar(cson__parser_t *p, const cson_handler_t *h, void *user) {
+    cson_token_t token = cson__advance(p);
+    switch (token.kind) {
+    case CSON_TK_NULL:
+        return cson__emit(h, null, user);
+    case CSON_TK_TRUE:
+        return cson__emit(h, boolean, user, true);
+    case CSON_TK_FALSE:
+        return cson__emit(h, boolean, user, false);
+    case CSON_TK_STRING:
+        return cson__sax_text(h->string, h->string_part, user, token);
+    case CSON_TK_NUMBER: {
+        cson_node_t node;
+        memset(&node, 0, sizeof(node));
+        cson__parse_number(&node, token.start, token.len);
+        if (!(node.flags & CSON_FLAG_INTEGER)) return cson__emit(h, number, user, node.as.number);
+        if (h->integer) return h->integer(user, node.as.integer);
+        return cson__emit(h, number, user, (double) node.as.integer);
+    }
+    default: cson__fatal("unexpected token at '%.*s'", (int) token.len, token.start);
+    }
+}
+
+// cson__sax_container - parse an object or array into callbacks
+// @p: pointer to parser, the lookahead is '{' or '['
+// @h: handler
+// @user: user pointer
+// Note: same grammar as cson__parse_container, without recursion, an open
+//       container only costs its bit in objects (set for an object)
+// Return: false if a callback asked to stop
+static bool cson__sax_container(cson__parser_t *p, const cson_handler_t *h, void *user) {
+    enum { OPEN, FIRST, MEMBER, NEXT } state = OPEN; // '{' or '[', member or close, member, ',' or close
+    uint64_t objects[CSON_MAX_DEPTH/64 + 1];
+    size_t base = p->depth;
+
+    while (1) {
+        if (state == OPEN) {
+            bool object = p->look.kind == CSON_TK_LCURLY;
+            cson__parser_enter(p);
+            cson__advance(p);
+            if (object) objects[p->depth/64] |= 1ull << (p->depth % 64);
+            else objects[p->depth/64] &= ~(1ull << (p->depth % 64));
+            if (object ? !cson__emit(h, start_object, user) : !cson__emit(h, start_array, user)) return false;
+            state = FIRST;
+            continue;
+        }
+        bool object = (objects[p->depth/64] >> (p->depth % 64)) & 1;
+        cson_token_kind_t close = object ? CSON_TK_RCURLY : CSON_TK_RSQUARE;
+        if (state == NEXT && p->look.kind == CSON_TK_COMMA) {
+            cson__advance(p);
+            state = MEMBER;
+            continue;
+        }
+        if (state == NEXT || (state == FIRST && p->look.kind == close)) {
+            cson__expect(p, close);
+            p->depth--;
+            if (object ? !cson__emit(h, end_object, user) : !cson__emit(h, end_array, user)) return false;
+            if (p->depth == base) return true;
+            state = NEXT;
+            continue;
+        }
+
+        if (object) {
+            cson_token_t key = cson__expect(p, CSON_TK_STRING);
+            cson__expect(p, CSON_TK_COLON);
+            if (!cson__sax_text(h->key, h->key_part, user, key)) return false;
+        }
+        if (p->look.kind == CSON_TK_LCURLY || p->look.kind == CSON_TK_LSQUARE) {
+            state = OPEN;
+            continue;
+        }
+        if (!cson__sax_scalar(p, h, user)) return false;
+        state = NEXT;
+    }
+}
+
+CSONDEF bool cson_parse_events(const char *buffer, size_t len, const cson_handler_t *handler, void *user) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.lex.keep_nul = true;
+    cson__advance(&p);
+    if (p.look.kind != CSON_TK_LCURLY) {
+        cson__fatal("expect %d, but got %d at '%.*s'", CSON_TK_LCURLY,
+                    p.look.kind, (int) p.look.len, p.look.start);
+    }
+    return cson__sax_container(&p, handler, user);
+}
+
+CSONDEF bool cson_parse_events_file(const char *path, const cson_handler_t *handler, void *user) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    bool done = cson_parse_events(file.data, file.len, handler, user);
+    cson__file_close(&file);
+    return done;
+}
+
+// cson__schema_skip - pass over a value without parsing it
+// @p: pointer to parser
+// Note: containers are jumped over with the structural scan of lazy loads
+static void cson__schema_skip(cson__parser_t *p) {
+    if (p->look.kind == CSON_TK_LCURLY || p->look.kind == CSON_TK_LSQUARE) {
+        const char *end = cson__skip_container(p->look.start, p->lex.end);
+        if (!end) cson__fatal("unterminated container at '%.*s'", 16, p->look.start);
+        p->lex.current = end;
+        cson__advance(p);
+        return;
+    }
+    cson_token_t token = cson__advance(p);
+    if (token.kind != CSON_TK_NULL && token.kind != CSON_TK_TRUE && token.kind != CSON_TK_FALSE &&
+        token.kind != CSON_TK_NUMBER && token.kind != CSON_TK_STRING) {
+        cson__fatal("unexpected token at '%.*s'", (int) token.len, token.start);
+    }
+}
+
+static uint64_t cson__schema_object(cson__parser_t *p, const cson_schema_t *schema, char *out);
+
+// cson__schema_field - write the lookahead value into a field
+// @p: pointer to parser
+// @field: field the value belongs to
+// @dst: address of the field
+// Return: false if the value has another type, then nothing is consumed
+static bool cson__schema_field(cson__parser_t *p, const cson_field_t *field, char *dst) {
+    cson_token_t token = p->look;
+    switch (field->kind) {
+    case CSON_FIELD_BOOLEAN:
+        if (token.kind != CSON_TK_TRUE && token.kind != CSON_TK_FALSE) return false;
+        *(bool *) dst = token.kind == CSON_TK_TRUE;
+        break;
+    case CSON_FIELD_INT64:
+    case CSON_FIELD_DOUBLE: {
+        if (token.kind != CSON_TK_NUMBER) return false;
+        cson_node_t node;
+        memset(&node, 0, sizeof(node));
+        node.kind = CSON_NUMBER;
+        cson__parse_number(&node, token.start, token.len);
+        if (field->kind == CSON_FIELD_INT64) *(int64_t *) dst = cson_to_int64(&node);
+        else *(double *) dst = cson_to_number(&node);
+    } break;
+    case CSON_FIELD_STRING: {
+        if (token.kind != CSON_TK_STRING) return false;
+        char *text = cson__strndup(token.start, token.len);
+        if (token.escaped) text[cson__unescape(text, text, token.len)] = '\0';
+        cson__free(*(char **) dst); // a repeated key or a reused struct
+        *(char **) dst = text;
+    } break;
+    case CSON_FIELD_CHARS: {
+        if (token.kind != CSON_TK_STRING || field->size == 0) return false;
+        char buf[CSON__TEXT_BUF];
+        size_t len = token.len;
+        const char *text = token.escaped ? cson__text_decode(token, buf, &len) : token.start;
+        size_t n = len < field->size - 1 ? len : field->size - 1;
+        // a cut never splits a utf-8 sequence
+        while (n < len && n > 0 && ((unsigned char) text[n] & 0xc0) == 0x80) n--;
+        memcpy(dst, text, n);
+        dst[n] = '\0';
+        if (text != buf && text != token.start) cson__free((char *) text);
+    } break;
+    case CSON_FIELD_OBJECT:
+        if (token.kind != CSON_TK_LCURLY || !field->schema) return false;
+        cson__schema_object(p, field->schema, dst);
+        return true;
+    default: return false;
+    }
+    cson__advance(p);
+    return true;
+}
+
+// cson__schema_object - parse an object into a struct
+// @p: pointer to parser, the lookahead is '{'
+// @schema: shape of the object
+// @out: struct address
+// Return: bit i is set if schema->fields[i] was written
+static uint64_t cson__schema_object(cson__parser_t *p, const cson_schema_t *schema, char *out) {
+    if (schema->len > 64) cson__fatal("schema has more than 64 fields");
+    uint64_t seen = 0;
+    cson__expect(p, CSON_TK_LCURLY);
+    if (p->look.kind != CSON_TK_RCURLY) {
+        while (1) {
+            cson_token_t key = cson__expect(p, CSON_TK_STRING);
+            cson__expect(p, CSON_TK_COLON);
+            char buf[CSON__TEXT_BUF];
+            size_t len = key.len;
+            const char *text = key.escaped ? cson__text_decode(key, buf, &len) : key.start;
+            size_t i = 0;
+            for (; i < schema->len; i++) {
+                const char *name = schema->fields[i].key;
+                if (strncmp(name, text, len) == 0 && name[len] == '\0') break;
+            }
+            if (text != buf && text != key.start) cson__free((char *) text);
+            if (i < schema->len && cson__schema_field(p, &schema->fields[i], out + schema->fields[i].offset)) {
+                seen |= 1ull << i;
+            } else {
+                cson__schema_skip(p);
+            }
+            if (p->look.kind != CSON_TK_COMMA) break;
+            cson__advance(p);
+        }
+    }
+    cson__expect(p, CSON_TK_RCURLY);
+    return seen;
+}
+
+CSONDEF uint64_t cson_parse_schema(const char *buffer, size_t len, const cson_schema_t *schema, void *out) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    cson__advance(&p);
+    if (p.look.kind != CSON_TK_LCURLY) {
+        cson__fatal("expect %d, but got %d at '%.*s'", CSON_TK_LCURLY,
+                    p.look.kind, (int) p.look.len, p.look.start);
+    }
+    return cson__schema_object(&p, schema, (char *) out);
+}
+
+CSONDEF uint64_t cson_parse_schema_file(const char *path, const cson_schema_t *schema, void *out) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    uint64_t seen = cson_parse_schema(file.data, file.len, schema, out);
+    cson__file_close(&file);
+    return seen;
+}
+
+// tape word tags, kept in the top byte of every word
+// '{' '[': payload is the member count (bits 32..55, saturated) and the index
+//          behind the closing word (bits 0..31)
+// '}' ']': payload is the index of the opening word
+// ':' '"': key or string, payload is its offset in the string buffer
+// 'l' 'd': int64 or double, the next word holds the bits
+// 't' 'f' 'n': true, false and null
+#define CSON__TAPE_TAG(word) ((unsigned char) ((word) >> 56))
+#define CSON__TAPE_PAYLOAD(word) ((word) & 0x00FFFFFFFFFFFFFFull)
+#define CSON__TAPE_COUNT_MAX 0xFFFFFFull
+
+// cson__tape_word - make a tape word
+// @tag: word tag
+// @payload: at most 56 bits
+// Return: tagged word
+static uint64_t cson__tape_word(unsigned char tag, uint64_t payload) {
+    return (uint64_t) tag << 56 | payload;
+}
+
+// cson__tape_push - append a word to the tape
+// @tape: tape being loaded
+// @word: word
+// Note: abort once jump offsets would pass 32 bits
+static void cson__tape_push(cson_tape_t *tape, uint64_t word) {
+    if (tape->len + 1 > tape->cap) {
+        if (tape->len >= UINT32_MAX) cson__fatal("document too large");
+        tape->cap = tape->cap < 1024 ? 1024 : 2*tape->cap;
+        tape->words = (uint64_t *) cson__realloc(tape->words, sizeof(uint64_t)*tape->cap);
+    }
+    tape->words[tape->len++] = word;
+}
+
+// cson__tape_string - copy key or string text into the string buffer
+// @tape: tape being loaded
+// @s: token text
+// @len: token length
+// @escaped: decode the escape sequences of s
+// Return: offset of its length prefix
+static uint64_t cson__tape_string(cson_tape_t *tape, const char *s, size_t len, bool escaped) {
+    if (len > UINT32_MAX) cson__fatal("string too large");
+    size_t need = tape->strings_len + sizeof(uint32_t) + len + 1;
+    if (need > tape->strings_cap) {
+        size_t cap = tape->strings_cap < 4096 ? 4096 : 2*tape->strings_cap;
+        while (cap < need) cap *= 2;
+        tape->strings = (char *) cson__realloc(tape->strings, cap);
+        tape->strings_cap = cap;
+    }
+    char *dst = tape->strings + tape->strings_len;
+    if (escaped) len = cson__unescape(dst + sizeof(uint32_t), s, len);
+    else memcpy(dst + sizeof(uint32_t), s, len);
+    uint32_t n = (uint32_t) len;
+    memcpy(dst, &n, sizeof(n));
+    dst[sizeof(n) + len] = '\0';
+
+    uint64_t offset = tape->strings_len;
+    tape->strings_len += sizeof(n) + len + 1;
+    return offset;
+}
+
+// cson__tape_close - close the innermost container of the tape
+// @tape: tape being filled
+// @open: index of the opening word
+// @count: member count
+// @object: close an object rather than an array
+// Note: the opening word is patched once the closing one is known
+static void cson__tape_close(cson_tape_t *tape, size_t open, uint64_t count, bool object) {
+    cson__tape_push(tape, cson__tape_word(object ? '}' : ']', open));
+    if (count > CSON__TAPE_COUNT_MAX) count = CSON__TAPE_COUNT_MAX;
+    tape->words[open] = cson__tape_word(object ? '{' : '[', count << 32 | tape->len);
+}
+
+// cson__tape_scalar - parse a scalar value into the tape
+// @p: pointer to parser
+// @tape: tape being loaded
+static void cson__tape_scalar(cson__parser_t *p, cson_tape_t *tape) {
+    cson_token_t token = cson__advance(p);
+    switch (token.kind) {
+    case CSON_TK_NULL:
+        cson__tape_push(tape, cson__tape_word('n', 0));
+        break;
+    case CSON_TK_TRUE:
+        cson__tape_push(tape, cson__tape_word('t', 0));
+        break;
+    case CSON_TK_FALSE:
+        cson__tape_push(tape, cson__tape_word('f', 0));
+        break;
+    case CSON_TK_STRING:
+        cson__tape_push(tape, cson__tape_word('"', cson__tape_string(tape, token.start, token.len, token.escaped)));
+        break;
+    case CSON_TK_NUMBER: {
+        cson_node_t node;
+        memset(&node, 0, sizeof(node));
+        cson__parse_number(&node, token.start, token.len);
+        uint64_t bits;
+        if (node.flags & CSON_FLAG_INTEGER) {
+            bits = (uint64_t) node.as.integer;
+            cson__tape_push(tape, cson__tape_word('l', 0));
+        } else {
+            memcpy(&bits, &node.as.number, sizeof(bits));
+            cson__tape_push(tape, cson__tape_word('d', 0));
+        }
+        cson__tape_push(tape, bits);
+    } break;
+    default: cson__fatal("unexpected token at '%.*s'", (int) token.len, token.start);
+    }
+}
+
+// cson__tape_open - open a container on the tape
+// @p: pointer to parser, the lookahead is '{' or '['
+// @tape: tape being loaded
+// @parent: index of the enclosing opening word, its own index for the root
+// Note: until the container closes, its opening word holds the member count
+//       and the parent index, so the tape itself is the stack of open containers
+// Return: index of the opening word
+static size_t cson__tape_open(cson__parser_t *p, cson_tape_t *tape, size_t parent) {
+    size_t open = tape->len;
+    cson__tape_push(tape, cson__tape_word(p->look.kind == CSON_TK_LCURLY ? '{' : '[', parent));
+    cson__parser_enter(p);
+    cson__advance(p);
+    return open;
+}
+
+// cson__tape_container - parse an object or array into the tape
+// @p: pointer to parser, the lookahead is '{' or '['
+// @tape: tape being loaded
+// Note: same grammar as cson__parse_container
+static void cson__tape_container(cson__parser_t *p, cson_tape_t *tape) {
+    enum { FIRST, MEMBER, NEXT } state = FIRST; // member or close, member, ',' or close
+    size_t open = cson__tape_open(p, tape, tape->len);
+
+    while (1) {
+        uint64_t word = tape->words[open];
+        bool object = CSON__TAPE_TAG(word) == '{';
+        cson_token_kind_t close = object ? CSON_TK_RCURLY : CSON_TK_RSQUARE;
+        if (state == NEXT && p->look.kind == CSON_TK_COMMA) {
+            cson__advance(p);
+            state = MEMBER;
+            continue;
+        }
+        if (state == NEXT || (state == FIRST && p->look.kind == close)) {
+            cson__expect(p, close);
+            size_t parent = (size_t) (word & 0xFFFFFFFFull);
+            cson__tape_close(tape, open, CSON__TAPE_PAYLOAD(word) >> 32, object);
+            p->depth--;
+            if (parent == open) return;
+            open = parent;
+            state = NEXT;
+            continue;
+        }
+
+        if ((CSON__TAPE_PAYLOAD(word) >> 32) < CSON__TAPE_COUNT_MAX) tape->words[open] += 1ull << 32;
+        if (object) {
+            cson_token_t key = cson__expect(p, CSON_TK_STRING);
+            cson__expect(p, CSON_TK_COLON);
+            cson__tape_push(tape, cson__tape_word(':', cson__tape_string(tape, key.start, key.len, key.escaped)));
+        }
+        if (p->look.kind == CSON_TK_LCURLY || p->look.kind == CSON_TK_LSQUARE) {
+            open = cson__tape_open(p, tape, open);
+            state = FIRST;
+            continue;
+        }
+        cson__tape_scalar(p, tape);
+        state = NEXT;
+    }
+}
+
+// cson__tape_reset - discard the previous document of tape
+// @tape: tape to reuse
+// Note: a binary file is closed, otherwise the buffers are kept for reuse
+static void cson__tape_reset(cson_tape_t *tape) {
+    if (tape->source) {
+        cson__file_t file = {tape->source, tape->source_len, tape->source_mapped};
+        cson__file_close(&file);
+        tape->words = NULL;
+        tape->strings = NULL;
+        tape->cap = 0;
+        tape->strings_cap = 0;
+        tape->source = NULL;
+        tape->source_len = 0;
+        tape->source_mapped = false;
+    }
+    tape->len = 0;
+    tape->strings_len = 0;
+}
+
+// cson__tape_parse - parse buffer into tape
+// @tape: tape to reuse
+// @buffer: json text
+// @len: text length
+static void cson__tape_parse(cson_tape_t *tape, const char *buffer, size_t len) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    p.lex.keep_nul = true;
+    cson__tape_reset(tape);
+    cson__advance(&p);
+    if (p.look.kind != CSON_TK_LCURLY) {
+        cson__fatal("expect %d, but got %d at '%.*s'", CSON_TK_LCURLY,
+                    p.look.kind, (int) p.look.len, p.look.start);
+    }
+    cson__tape_container(&p, tape);
+}
+
+// cson__tape_text - get the text of a key or string word
+// @tape: tape
+// @word: key or string word
+// @len: text length (Nullable)
+// Return: NUL-terminated text
+static const char *cson__tape_text(const cson_tape_t *tape, uint64_t word, size_t *len) {
+    const char *s = tape->strings + CSON__TAPE_PAYLOAD(word);
+    if (len) {
+        uint32_t n;
+        memcpy(&n, s, sizeof(n));
+        *len = n;
+    }
+    return s + sizeof(uint32_t);
+}
+
+// cson__tape_skip - get the word behind a value
+// @tape: tape
+// @idx: word of the value
+// Return: index of the next word
+static size_t cson__tape_skip(const cson_tape_t *tape, size_t idx) {
+    uint64_t word = tape->words[idx];
+    switch (CSON__TAPE_TAG(word)) {
+    case '{': case '[': return (uint32_t) word;
+    case 'l': case 'd': return idx + 2;
+    default: return idx + 1;
+    }
+}
+
+// cson__tape_member - get the member starting at a word
+// @tape: tape
+// @idx: word of a key, a value or a closing word
+// Return: the member, its tape is NULL at the closing word
+static cson_tape_ref_t cson__tape_member(const cson_tape_t *tape, size_t idx) {
+    cson_tape_ref_t ref = {NULL, 0, 0};
+    unsigned char tag = CSON__TAPE_TAG(tape->words[idx]);
+    if (tag == '}' || tag == ']') return ref;
+    ref.tape = tape;
+    if (tag == ':') {
+        ref.key = (uint32_t) idx;
+        idx++;
+    }
+    ref.idx = (uint32_t) idx;
+    return ref;
+}
+
+// cson__tape_container_of - check that ref is an object or array
+// @ref: value
+// @what: caller name for the error message
+static void cson__tape_container_of(cson_tape_ref_t ref, const char *what) {
+    if (!ref.tape) cson__fatal("%s: value does not exist", what);
+    unsigned char tag = CSON__TAPE_TAG(ref.tape->words[ref.idx]);
+    if (tag != '{' && tag != '[') cson__fatal("%s: should be an object or array value", what);
+}
+
+// cson__tape_number - view a number value as a node
+// @ref: value
+// Return: number node for the cson_to_xxx conversions, a null node otherwise
+static cson_node_t cson__tape_number(cson_tape_ref_t ref) {
+    cson_node_t node;
+    memset(&node, 0, sizeof(node));
+    if (!ref.tape) cson__fatal("value does not exist");
+    unsigned char tag = CSON__TAPE_TAG(ref.tape->words[ref.idx]);
+    if (tag != 'l' && tag != 'd') return node;
+    uint64_t bits = ref.tape->words[ref.idx + 1];
+    node.kind = CSON_NUMBER;
+    if (tag == 'l') {
+        node.flags = CSON_FLAG_INTEGER;
+        node.as.integer = (int64_t) bits;
+    } else {
+        memcpy(&node.as.number, &bits, sizeof(bits));
+    }
+    return node;
+}
+
+// cson__tape_from - copy a tree value into the tape
+// @tape: tape being filled
+// @node: value node
+static void cson__tape_from(cson_tape_t *tape, const cson_node_t *node) {
+    switch (node->kind) {
+    case CSON_OBJECT:
+    case CSON_ARRAY: {
+        if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+        bool object = node->kind == CSON_OBJECT;
+        const cson_nodes_t *da = &node->as.container;
+        size_t open = tape->len;
+        cson__tape_push(tape, 0);
+        for (size_t i = 0; i < da->len; i++) {
+            const cson_node_t *item = &da->items[i];
+            if (object) {
+                const char *key = item->key ? item->key : "";
+                cson__tape_push(tape, cson__tape_word(':', cson__tape_string(tape, key, strlen(key), false)));
+            }
+            cson__tape_from(tape, item);
+        }
+        cson__tape_close(tape, open, da->len, object);
+    } break;
+    case CSON_NUMBER: {
+        uint64_t bits;
+        if (node->flags & CSON_FLAG_INTEGER) {
+            bits = (uint64_t) node->as.integer;
+            cson__tape_push(tape, cson__tape_word('l', 0));
+        } else {
+            memcpy(&bits, &node->as.number, sizeof(bits));
+            cson__tape_push(tape, cson__tape_word('d', 0));
+        }
+        cson__tape_push(tape, bits);
+    } break;
+    case CSON_STRING: {
+        const char *value = cson_to_string(node);
+        if (!value) value = "";
+        cson__tape_push(tape, cson__tape_word('"', cson__tape_string(tape, value, strlen(value), false)));
+    } break;
+    case CSON_BOOLEAN:
+        cson__tape_push(tape, cson__tape_word(node->as.boolean ? 't' : 'f', 0));
+        break;
+    default:
+        cson__tape_push(tape, cson__tape_word('n', 0));
+        break;
+    }
+}
+
+#define CSON__TAPE_MAGIC "CSONTAPE"
+#define CSON__TAPE_VERSION 1
+#define CSON__TAPE_ORDER 0x01020304u
+
+// header of a binary tape file, the words and then the strings follow it
+typedef struct {
+    char magic[8];     // CSON__TAPE_MAGIC
+    uint32_t version;  // CSON__TAPE_VERSION
+    uint32_t order;    // CSON__TAPE_ORDER as written by the target
+    uint64_t words;    // word count
+    uint64_t strings;  // string buffer size
+} cson__tape_header_t;
+
+// cson__tape_check_string - check a key or string word of a loaded file
+// @tape: tape
+// @word: key or string word
+// Return: true if its length prefix, text and NUL end lie inside the strings
+static bool cson__tape_check_string(const cson_tape_t *tape, uint64_t word) {
+    uint64_t offset = CSON__TAPE_PAYLOAD(word);
+    if (offset > tape->strings_len || tape->strings_len - offset < sizeof(uint32_t) + 1) return false;
+    uint32_t n;
+    memcpy(&n, tape->strings + offset, sizeof(n));
+    size_t room = tape->strings_len - (size_t) offset - sizeof(uint32_t) - 1;
+    return n <= room && tape->strings[offset + sizeof(uint32_t) + n] == '\0';
+}
+
+// open container of cson__tape_check
+typedef struct {
+    size_t open;  // index of the opening word
+    size_t count; // members seen so far
+} cson__tape_level_t;
+
+// cson__tape_check - check the words of a loaded file in one pass
+// @tape: tape whose words and strings come from a file
+// Note: every container must close where its opening word says, with the
+//       right tag, back index and member count, object members alternate
+//       keys and values and every string lies inside the string buffer, so
+//       the accessors can not read outside the file; nothing is decoded
+// Return: false if the file is corrupted
+static bool cson__tape_check(const cson_tape_t *tape) {
+    cson__tape_level_t *levels = NULL;
+    size_t depth = 0, cap = 0, i = 0;
+    bool ok = false, keyed = false;
+    if (tape->len > UINT32_MAX || CSON__TAPE_TAG(tape->words[0]) != '{') return false;
+    for (; i < tape->len; i++) {
+        uint64_t word = tape->words[i];
+        unsigned char tag = CSON__TAPE_TAG(word);
+        bool object = depth && CSON__TAPE_TAG(tape->words[levels[depth - 1].open]) == '{';
+        if (tag == '}' || tag == ']') {
+            if (!depth || keyed) break;
+            cson__tape_level_t *top = &levels[depth - 1];
+            uint64_t open = tape->words[top->open];
+            size_t count = top->count < CSON__TAPE_COUNT_MAX ? top->count : CSON__TAPE_COUNT_MAX;
+            if (tag != (object ? '}' : ']') || CSON__TAPE_PAYLOAD(word) != top->open ||
+                (uint32_t) open != i + 1 || CSON__TAPE_PAYLOAD(open) >> 32 != count) {
+                break;
+            }
+            if (--depth == 0) {
+                ok = i + 1 == tape->len;
+                break;
+            }
+            continue;
+        }
+        if (object && !keyed) {
+            if (tag != ':' || !cson__tape_check_string(tape, word)) break;
+            keyed = true;
+            continue;
+        }
+        if (depth == 0 && i != 0) break;
+        if (depth) levels[depth - 1].count++;
+        keyed = false;
+        if (tag == '{' || tag == '[') {
+            if (depth == cap) {
+                cap = cap ? 2*cap : 64;
+                levels = (cson__tape_level_t *) cson__realloc(levels, sizeof(*levels)*cap);
+            }
+            levels[depth].open = i;
+            levels[depth].count = 0;
+            depth++;
+        } else if (tag == 'l' || tag == 'd') {
+            if (++i >= tape->len) break; // the word behind holds the bits
+        } else if (tag == '"') {
+            if (!cson__tape_check_string(tape, word)) break;
+        } else if (tag != 't' && tag != 'f' && tag != 'n') {
+            break;
+        }
+    }
+    cson__free(levels);
+    return ok;
+}
+
+CSONDEF cson_tape_ref_t cson_tape_load_buffer(cson_tape_t *tape, const char *buffer) {
+    cson__tape_parse(tape, buffer, strlen(buffer));
+    return cson_tape_root(tape);
+}
+
+CSONDEF cson_tape_ref_t cson_tape_load_file(cson_tape_t *tape, const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson__tape_parse(tape, file.data, file.len);
+    cson__file_close(&file);
+    return cson_tape_root(tape);
+}
+
+CSONDEF cson_tape_ref_t cson_tape_from_node(cson_tape_t *tape, const cson_node_t *root) {
+    if (root->kind != CSON_OBJECT) cson__fatal("root should be an object node");
+    cson__tape_reset(tape);
+    cson__tape_from(tape, root);
+    return cson_tape_root(tape);
+}
+
+CSONDEF cson_tape_ref_t cson_tape_load_binary(cson_tape_t *tape, const char *path) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson__tape_header_t header;
+    if (file.len < sizeof(header)) cson__fatal("'%s' is not a binary tape file", path);
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, CSON__TAPE_MAGIC, sizeof(header.magic)) != 0) {
+        cson__fatal("'%s' is not a binary tape file", path);
+    }
+    if (header.version != CSON__TAPE_VERSION || header.order != CSON__TAPE_ORDER) {
+        cson__fatal("'%s' was written by another format version or byte order", path);
+    }
+    size_t body = file.len - sizeof(header);
+    if (header.words == 0 || header.words > body/sizeof(uint64_t) ||
+        header.strings != body - sizeof(uint64_t)*header.words) {
+        cson__fatal("'%s' is truncated", path);
+    }
+
+    cson__tape_reset(tape);
+    cson__free(tape->words);
+    cson__free(tape->strings);
+    tape->words = (uint64_t *) (file.data + sizeof(header));
+    tape->len = (size_t) header.words;
+    tape->strings = file.data + sizeof(header) + sizeof(uint64_t)*header.words;
+    tape->strings_len = (size_t) header.strings;
+    tape->cap = 0;
+    tape->strings_cap = 0;
+    tape->source = file.data;
+    tape->source_len = file.len;
+    tape->source_mapped = file.mapped;
+    if (CSON__TAPE_TAG(tape->words[0]) != '{') cson__fatal("'%s' does not hold an object", path);
+    if (!cson__tape_check(tape)) cson__fatal("'%s' is corrupted", path);
+    return cson_tape_root(tape);
+}
+
+CSONDEF void cson_tape_generate_binary(const cson_tape_t *tape, const char *path) {
+    cson__tape_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CSON__TAPE_MAGIC, sizeof(header.magic));
+    header.version = CSON__TAPE_VERSION;
+    header.order = CSON__TAPE_ORDER;
+    header.words = tape->len;
+    header.strings = tape->strings_len;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) cson__fatal("failed to open file '%s'", path);
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(tape->words, sizeof(uint64_t), tape->len, f) == tape->len &&
+              fwrite(tape->strings, 1, tape->strings_len, f) == tape->strings_len;
+    if (fclose(f) != 0 || !ok) cson__fatal("failed to write file '%s'", path);
+}
+
+CSONDEF void cson_generate_binary(const cson_node_t *root, const char *path) {
+    cson_tape_t tape;
+    memset(&tape, 0, sizeof(tape));
+    cson_tape_from_node(&tape, root);
+    cson_tape_generate_binary(&tape, path);
+    cson_tape_free(&tape);
+}
+
+CSONDEF cson_node_t cson_load_binary(const char *path) {
+    cson_tape_t tape;
+    memset(&tape, 0, sizeof(tape));
+    cson_node_t root = cson_tape_to_node(cson_tape_load_binary(&tape, path));
+    cson_tape_free(&tape);
+    return root;
+}
+
+CSONDEF void cson_tape_free(cson_tape_t *tape) {
+    if (!tape) return;
+    cson__tape_reset(tape);
+    cson__free(tape->words);
+    cson__free(tape->strings);
+    memset(tape, 0, sizeof(*tape));
+}
+
+CSONDEF cson_tape_ref_t cson_tape_root(const cson_tape_t *tape) {
+    if (tape->len == 0) cson__fatal("tape is not loaded");
+    cson_tape_ref_t ref = {tape, 0, 0};
+    return ref;
+}
+
+CSONDEF cson_node_kind_t cson_tape_kind(cson_tape_ref_t ref) {
+    if (!ref.tape) cson__fatal("value does not exist");
+    switch (CSON__TAPE_TAG(ref.tape->words[ref.idx])) {
+    case '{': return CSON_OBJECT;
+    case '[': return CSON_ARRAY;
+    case '"': return CSON_STRING;
+    case 'l': case 'd': return CSON_NUMBER;
+    case 't': case 'f': return CSON_BOOLEAN;
+    default: return CSON_NULL;
+    }
+}
+
+CSONDEF cson_tape_ref_t cson_tape_query(cson_tape_ref_t ref, const char *key) {
+    if (cson_tape_kind(ref) != CSON_OBJECT) cson__fatal("query value should be an object");
+    cson_tape_ref_t none = {NULL, 0, 0};
+    if (!key) return none;
+    size_t len = strlen(key);
+    for (cson_tape_ref_t m = cson_tape_first(ref); m.tape; m = cson_tape_next(m)) {
+        size_t n;
+        const char *other = cson__tape_text(ref.tape, ref.tape->words[m.key], &n);
+        if (n == len && memcmp(other, key, len) == 0) return m;
+    }
+    return none;
+}
+
+CSONDEF size_t cson_tape_len(cson_tape_ref_t ref) {
+    cson__tape_container_of(ref, "cson_tape_len");
+    size_t count = (size_t) (CSON__TAPE_PAYLOAD(ref.tape->words[ref.idx]) >> 32);
+    if (count < CSON__TAPE_COUNT_MAX) return count;
+    count = 0;
+    for (cson_tape_ref_t m = cson_tape_first(ref); m.tape; m = cson_tape_next(m)) count++;
+    return count;
+}
+
+CSONDEF cson_tape_ref_t cson_tape_at(cson_tape_ref_t ref, size_t idx) {
+    cson_tape_ref_t m = cson_tape_first(ref);
+    while (m.tape && idx--) m = cson_tape_next(m);
+    return m;
+}
+
+CSONDEF cson_tape_ref_t cson_tape_first(cson_tape_ref_t ref) {
+    cson__tape_container_of(ref, "cson_tape_first");
+    return cson__tape_member(ref.tape, ref.idx + 1);
+}
+
+CSONDEF cson_tape_ref_t cson_tape_next(cson_tape_ref_t ref) {
+    if (!ref.tape) cson__fatal("value does not exist");
+    return cson__tape_member(ref.tape, cson__tape_skip(ref.tape, ref.idx));
+}
+
+CSONDEF const char *cson_tape_key(cson_tape_ref_t ref) {
+    if (!ref.tape) cson__fatal("value does not exist");
+    if (!ref.key) return NULL;
+    return cson__tape_text(ref.tape, ref.tape->words[ref.key], NULL);
+}
+
+CSONDEF double cson_tape_to_number(cson_tape_ref_t ref) {
+    if (!ref.tape) cson__fatal("value does not exist");
+    unsigned char tag = CSON__TAPE_TAG(ref.tape->words[ref.idx]);
+    uint64_t bits = ref.tape->words[ref.idx + 1];
+    if (tag == 'l') return (double) (int64_t) bits;
+    if (tag != 'd') cson__fatal("should be an number value");
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+CSONDEF int64_t cson_tape_to_int64(cson_tape_ref_t ref) {
+    cson_node_t node = cson__tape_number(ref);
+    if (node.kind != CSON_NUMBER) cson__fatal("should be an number value");
+    return cson_to_int64(&node);
+}
+
+CSONDEF bool cson_tape_to_boolean(cson_tape_ref_t ref) {
+    if (cson_tape_kind(ref) != CSON_BOOLEAN) cson__fatal("should be an boolean value");
+    return CSON__TAPE_TAG(ref.tape->words[ref.idx]) == 't';
+}
+
+CSONDEF const char *cson_tape_to_string(cson_tape_ref_t ref) {
+    if (cson_tape_kind(ref) != CSON_STRING) cson__fatal("should be an string value");
+    return cson__tape_text(ref.tape, ref.tape->words[ref.idx], NULL);
+}
+
+CSONDEF cson_node_t cson_tape_to_node(cson_tape_ref_t ref) {
+    const char *key = cson_tape_key(ref);
+    switch (cson_tape_kind(ref)) {
+    case CSON_OBJECT:
+    case CSON_ARRAY: {
+        // the member count is known, so the items get one exactly sized allocation
+        cson_node_t node = cson__create_node(cson_tape_kind(ref), key);
+        cson_nodes_t *da = &node.as.container;
+        uint32_t len = (uint32_t) cson_tape_len(ref);
+        if (len == 0) return node;
+        bool indexed = node.kind == CSON_OBJECT && len >= CSON_INDEX_THRESHOLD;
+        da->items = (cson_node_t *) cson__malloc(cson__items_size(len, indexed));
+        da->cap = len;
+        for (cson_tape_ref_t m = cson_tape_first(ref); m.tape; m = cson_tape_next(m)) {
+            da->items[da->len++] = cson_tape_to_node(m);
+        }
+        if (indexed) {
+            node.flags |= CSON_FLAG_INDEXED;
+            cson__index_build(da);
+        }
+        return node;
+    }
+    case CSON_NUMBER: {
+        cson_node_t node = cson__tape_number(ref);
+        node.key = key ? cson__strndup(key, strlen(key)) : NULL;
+        return node;
+    }
+    case CSON_STRING: return cson_create_string(key, cson_tape_to_string(ref));
+    case CSON_BOOLEAN: return cson_create_boolean(key, cson_tape_to_boolean(ref));
+    default: return cson_create_null(key);
+    }
+}
+
+// batch states of the ndjson loader
+enum {
+    CSON__BATCH_FREE,  // slot can take the next batch
+    CSON__BATCH_BUSY,  // a worker is parsing it
+    CSON__BATCH_READY  // parsed, waiting for delivery
+};
+
+// lines of ndjson parsed by one task
+typedef struct {
+    cson_arena_t arena;
+    cson_nodes_t records; // roots of the records, their trees live in arena
+    cson_nodes_t stack;   // scratch stack kept between the records
+    size_t index;         // batch number
+    int state;
+} cson__batch_t;
+
+typedef struct {
+    const char *buffer;
+    size_t len;
+    size_t pos;             // start of the next batch
+    size_t batch_size;
+    size_t claimed;         // batches handed out so far
+    bool stop;              // the callback asked to stop
+    cson_keytab_t *keys;
+    cson__batch_t *batches; // ring of slots, batch i uses slot i % cap
+    size_t cap;
+#if defined(CSON__THREADS)
+    pthread_mutex_t lock;
+    pthread_cond_t cond;    // signaled on every batch state change
+#endif
+} cson__ndjson_t;
+
+// cson__ndjson_cut - take the next batch of whole lines
+// @nd: loader
+// @len: output batch length
+// Return: start of the batch
+static const char *cson__ndjson_cut(cson__ndjson_t *nd, size_t *len) {
+    size_t start = nd->pos, end = start + nd->batch_size;
+    if (end >= nd->len) {
+        end = nd->len;
+    } else {
+        const char *nl = (const char *) memchr(nd->buffer + end, '\n', nd->len - end);
+        end = nl ? (size_t) (nl - nd->buffer) + 1 : nd->len;
+    }
+    nd->pos = end;
+    *len = end - start;
+    return nd->buffer + start;
+}
+
+// cson__ndjson_parse - parse every line of a batch
+// @batch: batch slot, its previous records are discarded
+// @p: first line
+// @len: byte count of the batch
+// @keys: key table (Nullable)
+// Note: blank lines are skipped, anything but spaces after a record aborts
+static void cson__ndjson_parse(cson__batch_t *batch, const char *p, size_t len, cson_keytab_t *keys) {
+    const char *end = p + len;
+    cson__arena_reset(&batch->arena);
+    batch->records.len = 0;
+
+    while (p < end) {
+        const char *nl = (const char *) memchr(p, '\n', (size_t) (end - p));
+        const char *eol = nl ? nl : end;
+        if (cson__skip_space(p, eol) < eol) {
+            cson__parser_t q;
+            cson__parser_init(&q, p, (size_t) (eol - p));
+            q.arena = &batch->arena;
+            q.keys = keys;
+            q.stack = batch->stack;
+            cson__advance(&q);
+            if (q.look.kind != CSON_TK_LCURLY) {
+                cson__fatal("expect %d, but got %d at '%.*s'", CSON_TK_LCURLY,
+                            q.look.kind, (int) q.look.len, q.look.start);
+            }
+            cson_node_t root = cson__parse_container(&q);
+            root.flags |= CSON_FLAG_ARENA;
+            if (q.look.kind != CSON_TK_EOF) {
+                cson__fatal("unexpected token after record at '%.*s'", (int) q.look.len, q.look.start);
+            }
+            batch->stack = q.stack;
+            cson__nodes_push(&batch->records, root);
+        }
+        if (!nl) break;
+        p = nl + 1;
+    }
+}
+
+#if defined(CSON__THREADS)
+// cson__ndjson_worker - parse batches until the input is used up
+// @arg: loader
+// Note: batch i waits for its slot to be delivered, so at most cap batches
+//       are parsed ahead of the callback
+static void *cson__ndjson_worker(void *arg) {
+    cson__ndjson_t *nd = (cson__ndjson_t *) arg;
+    pthread_mutex_lock(&nd->lock);
+    while (1) {
+        while (!nd->stop && nd->pos < nd->len &&
+               nd->batches[nd->claimed % nd->cap].state != CSON__BATCH_FREE) {
+            pthread_cond_wait(&nd->cond, &nd->lock);
+        }
+        if (nd->stop || nd->pos >= nd->len) break;
+
+        cson__batch_t *batch = &nd->batches[nd->claimed % nd->cap];
+        batch->index = nd->claimed++;
+        batch->state = CSON__BATCH_BUSY;
+        size_t len;
+        const char *start = cson__ndjson_cut(nd, &len);
+        pthread_mutex_unlock(&nd->lock);
+
+        cson__ndjson_parse(batch, start, len, nd->keys);
+
+        pthread_mutex_lock(&nd->lock);
+        batch->state = CSON__BATCH_READY;
+        pthread_cond_broadcast(&nd->cond);
+    }
+    pthread_mutex_unlock(&nd->lock);
+    return NULL;
+}
+#endif
+
+// cson__ndjson_deliver - hand the records of a batch to the callback
+// @batch: parsed batch
+// @cb: record callback
+// @user: passed to cb
+// @index: running record number
+// Return: false if cb asked to stop
+static bool cson__ndjson_deliver(cson__batch_t *batch, cson_record_cb_t cb, void *user, size_t *index) {
+    for (size_t i = 0; i < batch->records.len; i++) {
+        if (!cb(user, &batch->records.items[i], (*index)++)) return false;
+    }
+    return true;
+}
+
+// cson__thread_count - resolve a thread count option
+// @threads: requested count (0 means one per online cpu)
+// Return: at least 1
+static size_t cson__thread_count(size_t threads) {
+#if defined(CSON__THREADS) && defined(_SC_NPROCESSORS_ONLN)
+    if (threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (size_t) n : 1;
+    }
+#endif
+    return threads ? threads : 1;
+}
+
+CSONDEF bool cson_load_ndjson(const char *buffer, size_t len, const cson_ndjson_opts_t *opts,
+                              cson_record_cb_t cb, void *user) {
+    cson__ndjson_t nd;
+    memset(&nd, 0, sizeof(nd));
+    nd.buffer = buffer;
+    nd.len = len;
+    nd.batch_size = opts && opts->batch_size ? opts->batch_size : CSON_NDJSON_BATCH_SIZE;
+    nd.keys = opts ? opts->keys : NULL;
+
+    size_t index = 0;
+    bool ok = true;
+#if defined(CSON__THREADS)
+    size_t threads = cson__thread_count(opts ? opts->threads : 0);
+    if (threads > 1 && len > nd.batch_size) {
+        nd.cap = 2*threads;
+        nd.batches = (cson__batch_t *) cson__calloc(nd.cap, sizeof(cson__batch_t));
+        pthread_t *workers = (pthread_t *) cson__malloc(sizeof(pthread_t)*threads);
+        pthread_mutex_init(&nd.lock, NULL);
+        pthread_cond_init(&nd.cond, NULL);
+        for (size_t i = 0; i < threads; i++) {
+            if (pthread_create(&workers[i], NULL, cson__ndjson_worker, &nd) != 0) {
+                cson__fatal("failed to create thread");
+            }
+        }
+
+        for (size_t b = 0; ok; b++) {
+            cson__batch_t *batch = &nd.batches[b % nd.cap];
+            pthread_mutex_lock(&nd.lock);
+            while (!(batch->state == CSON__BATCH_READY && batch->index == b) &&
+                   !(nd.pos >= nd.len && b >= nd.claimed)) {
+                pthread_cond_wait(&nd.cond, &nd.lock);
+            }
+            bool done = b >= nd.claimed;
+            pthread_mutex_unlock(&nd.lock);
+            if (done) break;
+
+            ok = cson__ndjson_deliver(batch, cb, user, &index);
+
+            pthread_mutex_lock(&nd.lock);
+            batch->state = CSON__BATCH_FREE;
+            if (!ok) nd.stop = true;
+            pthread_cond_broadcast(&nd.cond);
+            pthread_mutex_unlock(&nd.lock);
+        }
+
+        for (size_t i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+        pthread_cond_destroy(&nd.cond);
+        pthread_mutex_destroy(&nd.lock);
+        cson__free(workers);
+    }
+#endif
+    if (!nd.batches) {
+        nd.cap = 1;
+        nd.batches = (cson__batch_t *) cson__calloc(1, sizeof(cson__batch_t));
+        while (ok && nd.pos < nd.len) {
+            size_t n;
+            const char *start = cson__ndjson_cut(&nd, &n);
+            cson__ndjson_parse(&nd.batches[0], start, n, nd.keys);
+            ok = cson__ndjson_deliver(&nd.batches[0], cb, user, &index);
+        }
+    }
+
+    for (size_t i = 0; i < nd.cap; i++) {
+        cson__arena_free(&nd.batches[i].arena);
+        cson__free(nd.batches[i].records.items);
+        cson__free(nd.batches[i].stack.items);
+    }
+    cson__free(nd.batches);
+    return ok;
+}
+
+CSONDEF bool cson_load_ndjson_file(const char *path, const cson_ndjson_opts_t *opts,
+                                   cson_record_cb_t cb, void *user) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    bool ok = cson_load_ndjson(file.data, file.len, opts, cb, user);
+    cson__file_close(&file);
+    return ok;
+}
+
+#if defined(CSON__THREADS)
+// cson__parse_value - parse json value
+// @p: pointer to parser
+// Note: abort if failed to parse value, and the result will be append to container,
+//       so it do not need to its pointer, otherwise there would be duplicate nodes
+// Return: value node without key yet
+static cson_node_t cson__parse_value(cson__parser_t *p) {
+    switch (p->look.kind) {
+    case CSON_TK_LCURLY:
+    case CSON_TK_LSQUARE:
+        if (p->lazy) return cson__parse_lazy(p);
+        return cson__parse_container(p);
+    default:
+        return cson__make_scalar(p, cson__advance(p));
+    }
+}
+
+// cson__parse_pair - parse json pair
+// @p: pointer to parser
+// Note: abort if failed to parse pair, and the result will be append to container,
+//       so it do not need to its pointer, otherwise there would be duplicate nodes
+// Return: pair node
+static cson_node_t cson__parse_pair(cson__parser_t *p) {
+    cson_token_t key = cson__expect(p, CSON_TK_STRING);
+    cson__expect(p, CSON_TK_COLON);
+    cson_node_t node = cson__parse_value(p);
+    node.key = cson__make_key(p, key, &node.flags);
+    return node;
+}
+
+// elements of one container, parsed by one task of the parallel parser
+typedef struct {
+    const char *start;     // first element, the range ends before a ',' or bracket
+    size_t len;
+    size_t member;         // 0 for members of the root, otherwise the member number
+    cson_node_kind_t kind; // container the elements belong to
+    cson_token_t key;      // key of the member (unused for the root)
+    cson_nodes_t nodes;    // parsed elements
+} cson__range_t;
+
+typedef struct {
+    cson__range_t *ranges; // in text order
+    size_t count;
+    size_t cap;
+    size_t next;           // first range not taken yet
+    bool scanned;          // the pass is over, no range will be added
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} cson__split_t;
+
+// cson__token_begin - get where the text of a token starts
+// @token: token
+// Return: first byte, the opening '"' for strings
+static const char *cson__token_begin(cson_token_t token) {
+    return token.kind == CSON_TK_STRING ? token.start - 1 : token.start;
+}
+
+// cson__split_add - publish a range for the workers
+// @sp: splitter
+// @range: range to copy
+static void cson__split_add(cson__split_t *sp, const cson__range_t *range) {
+    pthread_mutex_lock(&sp->lock);
+    if (sp->count + 1 > sp->cap) {
+        sp->cap = sp->cap < 64 ? 64 : 2*sp->cap;
+        sp->ranges = (cson__range_t *) cson__realloc(sp->ranges, sizeof(cson__range_t)*sp->cap);
+    }
+    sp->ranges[sp->count++] = *range;
+    pthread_cond_signal(&sp->cond);
+    pthread_mutex_unlock(&sp->lock);
+}
+
+// cson__split_emit - publish the text between two positions as a range
+// @sp: splitter
+// @start: first element
+// @end: separator after the last element
+// @member: member number (0 for the root)
+// @kind: container type
+// @key: member key (ignored for the root)
+static void cson__split_emit(cson__split_t *sp, const char *start, const char *end,
+                             size_t member, cson_node_kind_t kind, cson_token_t key) {
+    cson__range_t range;
+    memset(&range, 0, sizeof(range));
+    range.start = start;
+    range.len = (size_t) (end - start);
+    range.member = member;
+    range.kind = kind;
+    range.key = key;
+    cson__split_add(sp, &range);
+}
+
+// cson__split_member - walk the elements of a member container
+// @sp: splitter
+// @p: parser, the lookahead is the opening bracket of the member value
+// @member: member number
+// @key: member key
+// @cut: range size
+// @pending: start of the root members waiting for a range (Nullable)
+// @before: separator in front of this member
+// Note: elements are only lexed or skipped, a member that reaches cut bytes
+//       is split into its own ranges of about cut bytes each
+// Return: true if the member was split
+static bool cson__split_member(cson__split_t *sp, cson__parser_t *p, size_t member, cson_token_t key,
+                               size_t cut, const char **pending, const char *before) {
+    bool object = p->look.kind == CSON_TK_LCURLY;
+    cson_node_kind_t kind = object ? CSON_OBJECT : CSON_ARRAY;
+    cson_token_kind_t close = object ? CSON_TK_RCURLY : CSON_TK_RSQUARE;
+    const char *open = p->look.start;
+    cson__advance(p);
+
+    bool split = false;
+    const char *first = cson__token_begin(p->look);
+    if (p->look.kind != close) {
+        while (1) {
+            if (object) {
+                cson__expect(p, CSON_TK_STRING);
+                cson__expect(p, CSON_TK_COLON);
+            }
+            if (p->look.kind == CSON_TK_LCURLY || p->look.kind == CSON_TK_LSQUARE) {
+                const char *end = cson__skip_container(p->look.start, p->lex.end);
+                if (!end) cson__fatal("unterminated container at '%.*s'", 16, p->look.start);
+                p->lex.current = end;
+            }
+            cson__advance(p);
+
+            const char *sep = p->look.start;
+            if (!split && (size_t) (sep - open) >= cut) {
+                // the members in front of this one go first
+                if (*pending) cson__split_emit(sp, *pending, before, 0, CSON_OBJECT, p->look);
+                *pending = NULL;
+                split = true;
+            }
+            if (split && first && (size_t) (sep - first) >= cut) {
+                cson__split_emit(sp, first, sep, member, kind, key);
+                first = NULL;
+            }
+            if (p->look.kind != CSON_TK_COMMA) break;
+            cson__advance(p);
+            if (!first) first = cson__token_begin(p->look);
+        }
+    }
+    if (split && first) cson__split_emit(sp, first, p->look.start, member, kind, key);
+    cson__expect(p, close);
+    return split;
+}
+
+// cson__split_scan - cut the document into ranges
+// @sp: splitter
+// @buffer: json text
+// @len: text length
+// @cut: range size
+static void cson__split_scan(cson__split_t *sp, const char *buffer, size_t len, size_t cut) {
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    cson__advance(&p);
+    cson__expect(&p, CSON_TK_LCURLY);
+
+    const char *pending = NULL, *before = p.look.start;
+    size_t member = 0;
+    if (p.look.kind != CSON_TK_RCURLY) {
+        while (1) {
+            const char *start = cson__token_begin(p.look);
+            cson_token_t key = cson__expect(&p, CSON_TK_STRING);
+            cson__expect(&p, CSON_TK_COLON);
+            bool split = false;
+            if (p.look.kind == CSON_TK_LCURLY || p.look.kind == CSON_TK_LSQUARE) {
+                split = cson__split_member(sp, &p, ++member, key, cut, &pending, before);
+            } else {
+                cson__advance(&p);
+            }
+
+            if (!split) {
+                if (!pending) pending = start;
+                if ((size_t) (p.look.start - pending) >= cut) {
+                    cson__split_emit(sp, pending, p.look.start, 0, CSON_OBJECT, p.look);
+                    pending = NULL;
+                }
+            }
+            before = p.look.start;
+            if (p.look.kind != CSON_TK_COMMA) break;
+            cson__advance(&p);
+        }
+    }
+    if (pending) cson__split_emit(sp, pending, p.look.start, 0, CSON_OBJECT, p.look);
+    cson__expect(&p, CSON_TK_RCURLY);
+}
+
+// cson__split_parse - parse the elements of a range
+// @range: range, its nodes are filled
+static void cson__split_parse(cson__range_t *range) {
+    cson__parser_t q;
+    cson__parser_init(&q, range->start, range->len);
+    q.depth = range->member ? 2 : 1; // the root, and the member that holds the range
+    cson__advance(&q);
+    while (1) {
+        cson__parser_push(&q, range->kind == CSON_OBJECT ? cson__parse_pair(&q) : cson__parse_value(&q));
+        if (q.look.kind != CSON_TK_COMMA) break;
+        cson__advance(&q);
+    }
+    if (q.look.kind != CSON_TK_EOF) {
+        cson__fatal("unexpected token at '%.*s'", (int) q.look.len, q.look.start);
+    }
+    range->nodes = q.stack;
+}
+
+// cson__split_work - parse ranges until the pass is over and none is left
+// @arg: splitter
+// Return: NULL
+static void *cson__split_work(void *arg) {
+    cson__split_t *sp = (cson__split_t *) arg;
+    while (1) {
+        pthread_mutex_lock(&sp->lock);
+        while (sp->next >= sp->count && !sp->scanned) pthread_cond_wait(&sp->cond, &sp->lock);
+        if (sp->next >= sp->count) {
+            pthread_mutex_unlock(&sp->lock);
+            return NULL;
+        }
+        size_t i = sp->next++;
+        cson__range_t range = sp->ranges[i];
+        pthread_mutex_unlock(&sp->lock);
+
+        cson__split_parse(&range);
+
+        pthread_mutex_lock(&sp->lock);
+        sp->ranges[i].nodes = range.nodes;
+        pthread_mutex_unlock(&sp->lock);
+    }
+}
+
+// cson__split_merge - assemble the root from the parsed ranges
+// @sp: splitter with every range parsed
+// Note: goes through cson__parser_close like the sequential parser, so the
+//       allocations, indexes and flags are the same
+// Return: root node
+static cson_node_t cson__split_merge(cson__split_t *sp) {
+    cson__parser_t m;
+    memset(&m, 0, sizeof(m));
+    for (size_t i = 0; i < sp->count;) {
+        cson__range_t *range = &sp->ranges[i];
+        if (range->member == 0) {
+            for (size_t k = 0; k < range->nodes.len; k++) cson__parser_push(&m, range->nodes.items[k]);
+            cson__free(range->nodes.items);
+            i++;
+            continue;
+        }
+        size_t base = m.stack.len, member = range->member;
+        for (; i < sp->count && sp->ranges[i].member == member; i++) {
+            cson_nodes_t *nodes = &sp->ranges[i].nodes;
+            for (size_t k = 0; k < nodes->len; k++) cson__parser_push(&m, nodes->items[k]);
+            cson__free(nodes->items);
+        }
+        cson_node_t node = cson__parser_close(&m, range->kind, base);
+        node.key = cson__make_key(&m, range->key, &node.flags);
+        cson__parser_push(&m, node);
+    }
+    cson_node_t root = cson__parser_close(&m, CSON_OBJECT, 0);
+    cson__free(m.stack.items);
+    return root;
+}
+#endif
+
+CSONDEF cson_node_t cson_load_buffer_parallel(const char *buffer, size_t len, size_t threads) {
+    threads = cson__thread_count(threads);
+    size_t cut = len/(8*threads);
+    if (cut < 64*1024) cut = 64*1024;
+
+#if defined(CSON__THREADS)
+    if (threads > 1 && len >= 2*cut) {
+        cson__split_t sp;
+        memset(&sp, 0, sizeof(sp));
+        pthread_mutex_init(&sp.lock, NULL);
+        pthread_cond_init(&sp.cond, NULL);
+        pthread_t *workers = (pthread_t *) cson__malloc(sizeof(pthread_t)*(threads - 1));
+        for (size_t i = 0; i + 1 < threads; i++) {
+            if (pthread_create(&workers[i], NULL, cson__split_work, &sp) != 0) {
+                cson__fatal("failed to create thread");
+            }
+        }
+
+        cson__split_scan(&sp, buffer, len, cut);
+        pthread_mutex_lock(&sp.lock);
+        sp.scanned = true;
+        pthread_cond_broadcast(&sp.cond);
+        pthread_mutex_unlock(&sp.lock);
+        cson__split_work(&sp); // the scanning thread helps with the rest
+
+        for (size_t i = 0; i + 1 < threads; i++) pthread_join(workers[i], NULL);
+        cson__free(workers);
+        pthread_cond_destroy(&sp.cond);
+        pthread_mutex_destroy(&sp.lock);
+
+        cson_node_t root = cson__split_merge(&sp);
+        cson__free(sp.ranges);
+        return root;
+    }
+#endif
+    cson__parser_t p;
+    cson__parser_init(&p, buffer, len);
+    return cson__parse_root(&p);
+}
+
+CSONDEF cson_node_t cson_load_file_parallel(const char *path, size_t threads) {
+    cson__file_t file;
+    if (!cson__file_open(&file, path, false)) cson__fatal("empty file or error occurs when reading file");
+    cson_node_t root = cson_load_buffer_parallel(file.data, file.len, threads);
+    cson__file_close(&file);
+    return root;
+}
+
+
+#ifndef CSON_WRITE_BUFFER_SIZE
+#define CSON_WRITE_BUFFER_SIZE (64*1024)
+#endif
+
+typedef struct {
+    const cson_node_t *node; // container being written
+    uint32_t next;           // index of its next member
+} cson__dump_frame_t;
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    cson_sink_t sink; // NULL if the output stays in buf
+    void *user;
+    bool failed;      // a sink call reported an error
+    bool compact;
+    size_t indent;
+    cson__dump_frame_t *frames; // open containers
+    size_t depth;
+    uint32_t frames_cap;
+    size_t level;     // indent level of the value cson__dump starts at
+} cson__writer_t;
+
+// cson__writer_flush - hand the buffered bytes to the sink
+// @w: pointer to writer
+static void cson__writer_flush(cson__writer_t *w) {
+    if (!w->sink || w->len == 0) return;
+    if (!w->failed && !w->sink(w->user, w->buf, w->len)) w->failed = true;
+    w->len = 0;
+}
+
+// cson__writer_reserve - make room for n more bytes
+// @w: pointer to writer
+// @n: byte count
+// Return: pointer to the free space
+static char *cson__writer_reserve(cson__writer_t *w, size_t n) {
+    if (w->len + n <= w->cap) return w->buf + w->len;
+    if (w->sink) cson__writer_flush(w);
+    if (w->len + n > w->cap) {
+        size_t cap = w->cap ? w->cap : CSON_WRITE_BUFFER_SIZE;
+        while (cap < w->len + n) cap *= 2;
+        w->buf = (char *) cson__realloc(w->buf, cap);
+        w->cap = cap;
+    }
+    return w->buf + w->len;
+}
+
+// cson__writer_put - append bytes
+// @w: pointer to writer
+// @s: bytes
+// @n: byte count
+static void cson__writer_put(cson__writer_t *w, const char *s, size_t n) {
+    if (w->sink && n >= CSON_WRITE_BUFFER_SIZE) {
+        // large chunks bypass the buffer
+        cson__writer_flush(w);
+        if (!w->failed && !w->sink(w->user, s, n)) w->failed = true;
+        return;
+    }
+    memcpy(cson__writer_reserve(w, n), s, n);
+    w->len += n;
+}
+
+#define cson__writer_puts(w, lit) cson__writer_put((w), (lit), sizeof(lit) - 1)
+
+// cson__writer_putc - append one byte
+// @w: pointer to writer
+// @c: byte
+static void cson__writer_putc(cson__writer_t *w, char c) {
+    *cson__writer_reserve(w, 1) = c;
+    w->len++;
+}
+
+// cson__format_int64 - format an integer
+// @buf: output (at least 21 bytes)
+// @value: integer
+// Return: length
+static size_t cson__format_int64(char *buf, int64_t value) {
+    char tmp[20];
+    size_t n = 0, len = 0;
+    uint64_t u = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    do {
+        tmp[n++] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (value < 0) buf[len++] = '-';
+    while (n) buf[len++] = tmp[--n];
+    return len;
+}
+
+// cson__format_double - format a double with the shortest round-trip form
+// @buf: output (at least 32 bytes)
+// @value: number
+// Note: integral values are printed exactly, short decimals are built from
+//       a scaled integer, others try 15, 16, then 17 significant digits and
+//       keep the first that reads back unchanged, nan and inf become null
+// Return: length
+static size_t cson__format_double(char *buf, double value) {
+    if (value != value || value - value != 0) {
+        memcpy(buf, "null", 4);
+        return 4;
+    }
+    if (value == 0) {
+        if (signbit(value)) { memcpy(buf, "-0", 2); return 2; }
+        buf[0] = '0';
+        return 1;
+    }
+    if (value >= -9007199254740992.0 && value <= 9007199254740992.0 &&
+        (double) (int64_t) value == value) {
+        return cson__format_int64(buf, (int64_t) value);
+    }
+
+    // short decimals: find the fewest fraction digits k with m / 10^k == value,
+    // which is exactly what the parser computes when reading "m.k" back
+    double mag = value < 0 ? -value : value;
+    if (mag >= 1e-5) {
+        for (int k = 1; k <= 17; k++) {
+            double scaled = mag*cson__pow10[k];
+            if (scaled >= 9007199254740992.0) break;
+            uint64_t m = (uint64_t) (scaled + 0.5);
+            if ((double) m/cson__pow10[k] != mag) continue;
+
+            char digits[20];
+            size_t n = cson__format_int64(digits, (int64_t) m), len = 0;
+            if (value < 0) buf[len++] = '-';
+            if (n <= (size_t) k) {
+                buf[len++] = '0';
+                buf[len++] = '.';
+                for (size_t i = n; i < (size_t) k; i++) buf[len++] = '0';
+                memcpy(buf + len, digits, n);
+                len += n;
+            } else {
+                memcpy(buf + len, digits, n - k);
+                len += n - k;
+                buf[len++] = '.';
+                memcpy(buf + len, digits + n - k, k);
+                len += k;
+            }
+            return len;
+        }
+    }
+
+    int len = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        len = snprintf(buf, 32, "%.*g", precision, value);
+        if (strtod(buf, NULL) == value) break;
+    }
+    char point = localeconv()->decimal_point[0];
+    if (point != '.') {
+        for (int i = 0; i < len; i++) if (buf[i] == point) buf[i] = '.';
+    }
+    return (size_t) len;
+}
+
+// cson__dump_newline - output line break unless compact
+// @w: pointer to writer
+static void cson__dump_newline(cson__writer_t *w) {
+    if (!w->compact) cson__writer_putc(w, '\n');
+}
+
+// cson__dump_indent - output indent with level
+// @w: pointer to writer
+// @level: current level
+static void cson__dump_indent(cson__writer_t *w, size_t level) {
+    static const char spaces[] = "                                                                ";
+    if (w->compact) return;
+    size_t n = w->indent*(w->level + level);
+    while (n > 0) {
+        size_t chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        cson__writer_put(w, spaces, chunk);
+        n -= chunk;
+    }
+}
+
+// cson__writer_escaped - append a string with json escapes
+// @w: pointer to writer
+// @s: string bytes
+// @n: byte count
+// Note: room for the worst case of a slice is reserved once, so runs that need
+//       no escape are found a vector at a time and copied without any more
+//       checks, bytes above 0x7f pass through
+static void cson__writer_escaped(cson__writer_t *w, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    const char *end = s + n;
+    while (s < end) {
+        const char *stop = end - s > 4096 ? s + 4096 : end;
+        char *start = cson__writer_reserve(w, 6*(size_t) (stop - s)), *out = start;
+        while (1) {
+            const char *at = cson__scan_escape(s, stop);
+            memcpy(out, s, (size_t) (at - s));
+            out += at - s;
+            if (at == stop) break;
+            unsigned char c = (unsigned char) *at;
+            s = at + 1;
+            *out++ = '\\';
+            switch (c) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '\b': *out++ = 'b'; break;
+            case '\f': *out++ = 'f'; break;
+            case '\n': *out++ = 'n'; break;
+            case '\r': *out++ = 'r'; break;
+            case '\t': *out++ = 't'; break;
+            default:
+                memcpy(out, "u00", 3);
+                out[3] = hex[c >> 4];
+                out[4] = hex[c & 15];
+                out += 5;
+            }
+        }
+        w->len += (size_t) (out - start);
+        s = stop;
+    }
+}
+
+// cson__dump_scalar - output a value that is not a container
+// @w: pointer to writer
+// @node: current node
+static void cson__dump_scalar(cson__writer_t *w, const cson_node_t *node) {
+    switch (node->kind) {
+    case CSON_STRING:
+        cson__writer_putc(w, '"');
+        if (node->flags & CSON_FLAG_INLINE) cson__writer_escaped(w, node->as.small, strlen(node->as.small));
+        else if (node->as.string) cson__writer_escaped(w, node->as.string, strlen(node->as.string));
+        cson__writer_putc(w, '"');
+        break;
+
+    case CSON_NUMBER: {
+        char *buf = cson__writer_reserve(w, 32);
+        if (node->flags & CSON_FLAG_INTEGER) w->len += cson__format_int64(buf, node->as.integer);
+        else w->len += cson__format_double(buf, node->as.number);
+    } break;
+
+    case CSON_BOOLEAN:
+        if (node->as.boolean) cson__writer_puts(w, "true");
+        else cson__writer_puts(w, "false");
+        break;
+
+    case CSON_NULL:
+        cson__writer_puts(w, "null");
+        break;
+
+    default:
+        break;
+    }
+}
+
+// cson__dump_open - output the opening of a value
+// @w: pointer to writer
+// @node: current node
+// Note: a container is pushed on the writer stack, its members follow
+static void cson__dump_open(cson__writer_t *w, const cson_node_t *node) {
+    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
+        cson__dump_scalar(w, node);
+        return;
+    }
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+    if (w->depth == w->frames_cap) {
+        w->frames_cap = cson__grow(w->frames_cap, 32);
+        w->frames = (cson__dump_frame_t *) cson__realloc(w->frames, sizeof(cson__dump_frame_t)*w->frames_cap);
+    }
+    w->frames[w->depth].node = node;
+    w->frames[w->depth].next = 0;
+    w->depth++;
+    cson__writer_putc(w, node->kind == CSON_OBJECT ? '{' : '[');
+    cson__dump_newline(w);
+}
+
+// cson__dump - output a value
+// @w: pointer to writer
+// @root: value
+// Note: nested containers take writer stack slots instead of call frames,
+//       so any tree can be written whatever its depth
+static void cson__dump(cson__writer_t *w, const cson_node_t *root) {
+    cson__dump_open(w, root);
+    while (w->depth > 0) {
+        cson__dump_frame_t *frame = &w->frames[w->depth - 1];
+        const cson_nodes_t *da = &frame->node->as.container;
+        if (frame->next > 0) {
+            // the previous member is complete
+            if (frame->next < da->len) cson__writer_putc(w, ',');
+            cson__dump_newline(w);
+        }
+        if (frame->next == da->len) {
+            bool object = frame->node->kind == CSON_OBJECT;
+            w->depth--;
+            cson__dump_indent(w, w->depth);
+            cson__writer_putc(w, object ? '}' : ']');
+            continue;
+        }
+
+        const cson_node_t *node = &da->items[frame->next++];
+        cson__dump_indent(w, w->depth);
+        if (frame->node->kind == CSON_OBJECT) {
+            const char *key = node->key ? node->key : "";
+            cson__writer_putc(w, '"');
+            cson__writer_escaped(w, key, strlen(key));
+            if (w->compact) cson__writer_puts(w, "\":");
+            else cson__writer_puts(w, "\": ");
+        }
+        cson__dump_open(w, node);
+    }
+}
+
+// cson__writer_init - prepare a writer
+// @w: pointer to writer
+// @sink: output callback (Nullable, keep the output in memory)
+// @user: passed to sink
+// @opts: output options (Nullable)
+static void cson__writer_init(cson__writer_t *w, cson_sink_t sink, void *user,
+                              const cson_write_opts_t *opts) {
+    memset(w, 0, sizeof(*w));
+    w->sink = sink;
+    w->user = user;
+    w->indent = 4;
+    if (opts) {
+        w->compact = opts->compact;
+        if (opts->indent) w->indent = opts->indent;
+    }
+}
+
+// cson__sink_file - sink writing into a FILE pointer
+// @user: FILE pointer
+// @data: bytes to write
+// @len: byte count
+// Return: false on write error
+static bool cson__sink_file(void *user, const char *data, size_t len) {
+    return fwrite(data, 1, len, (FILE *) user) == len;
+}
+
+// cson__sink_fd - sink writing into a file descriptor
+// @user: pointer to the descriptor
+// @data: bytes to write
+// @len: byte count
+// Note: retries short writes and EINTR
+// Return: false on write error
+static bool cson__sink_fd(void *user, const char *data, size_t len) {
+    int fd = *(int *) user;
+    while (len > 0) {
+#if defined(_WIN32)
+        int n = _write(fd, data, (unsigned) (len > 0x40000000 ? 0x40000000 : len));
+#else
+        ssize_t n = write(fd, data, len);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t) n;
+    }
+    return true;
+}
+
+CSONDEF bool cson_write_to_sink(const cson_node_t *root, cson_sink_t sink, void *user,
+                                const cson_write_opts_t *opts) {
+    cson__writer_t w;
+    cson__writer_init(&w, sink, user, opts);
+    cson__dump(&w, root);
+    cson__writer_flush(&w);
+    cson__free(w.buf);
+    cson__free(w.frames);
+    return !w.failed;
+}
+
+CSONDEF char *cson_write_to_buffer(const cson_node_t *root, size_t *len, const cson_write_opts_t *opts) {
+    cson__writer_t w;
+    cson__writer_init(&w, NULL, NULL, opts);
+    cson__dump(&w, root);
+    cson__free(w.frames);
+    cson__writer_putc(&w, '\0');
+    if (len) *len = w.len - 1;
+    return w.buf;
+}
+
+CSONDEF bool cson_write_fd(const cson_node_t *root, int fd, const cson_write_opts_t *opts) {
+    return cson_write_to_sink(root, cson__sink_fd, &fd, opts);
+}
+
+CSONDEF void cson_write(const cson_node_t *root, FILE *f) {
+    cson_write_ex(root, f, NULL);
+}
+
+CSONDEF void cson_write_ex(const cson_node_t *root, FILE *f, const cson_write_opts_t *opts) {
+    cson_write_to_sink(root, cson__sink_file, f, opts);
+}
+
+CSONDEF void cson_generate_file(const cson_node_t *root, const char *path) {
+    cson_generate_file_ex(root, path, NULL);
+}
+
+CSONDEF void cson_generate_file_ex(const cson_node_t *root, const char *path,
+                                   const cson_write_opts_t *opts) {
+    FILE *f = fopen(path, "wb");
+    if (!f) cson__fatal("failed to open file '%s'", path);
+    cson_write_ex(root, f, opts);
+    fclose(f);
+}
+
+// container still open in a stream
+typedef struct {
+    bool object;
+    size_t count; // members written so far
+} cson__stream_frame_t;
+
+struct cson_stream {
+    cson__writer_t w;
+    cson__stream_frame_t *frames;
+    size_t depth;
+    size_t cap;
+    bool keyed; // a key was written, its value comes next
+    bool done;  // the root value is complete
+};
+
+CSONDEF cson_stream_t *cson_stream_open(cson_sink_t sink, void *user, const cson_write_opts_t *opts) {
+    if (!sink) cson__fatal("stream needs a sink");
+    cson_stream_t *s = (cson_stream_t *) cson__calloc(1, sizeof(cson_stream_t));
+    cson__writer_init(&s->w, sink, user, opts);
+    return s;
+}
+
+CSONDEF cson_stream_t *cson_stream_open_file(FILE *f, const cson_write_opts_t *opts) {
+    return cson_stream_open(cson__sink_file, f, opts);
+}
+
+// cson__stream_member - output what precedes a member and count it
+// @s: stream
+// Note: the separator and indent of the previous member, same as cson__dump
+static void cson__stream_member(cson_stream_t *s) {
+    cson__stream_frame_t *frame = &s->frames[s->depth - 1];
+    if (frame->count++ > 0) {
+        cson__writer_putc(&s->w, ',');
+        cson__dump_newline(&s->w);
+    }
+    cson__dump_indent(&s->w, s->depth);
+}
+
+// cson__stream_value - check that a value may come now and output its prefix
+// @s: stream
+static void cson__stream_value(cson_stream_t *s) {
+    if (s->done) cson__fatal("stream already holds a complete document");
+    if (s->depth == 0) return;
+    if (s->frames[s->depth - 1].object) {
+        if (!s->keyed) cson__fatal("stream expects a key");
+        s->keyed = false;
+        return;
+    }
+    cson__stream_member(s);
+}
+
+// cson__stream_scalar_done - mark the root complete after a top level scalar
+static void cson__stream_scalar_done(cson_stream_t *s) {
+    if (s->depth == 0) s->done = true;
+}
+
+// cson__stream_begin - open a container
+// @s: stream
+// @object: true for an object
+static void cson__stream_begin(cson_stream_t *s, bool object) {
+    cson__stream_value(s);
+    if (s->depth == s->cap) {
+        s->cap = s->cap ? 2*s->cap : 32;
+        s->frames = (cson__stream_frame_t *) cson__realloc(s->frames, sizeof(cson__stream_frame_t)*s->cap);
+    }
+    s->frames[s->depth].object = object;
+    s->frames[s->depth].count = 0;
+    s->depth++;
+    cson__writer_putc(&s->w, object ? '{' : '[');
+    cson__dump_newline(&s->w);
+}
+
+// cson__stream_end - close a container
+// @s: stream
+// @object: true for an object
+static void cson__stream_end(cson_stream_t *s, bool object) {
+    if (s->depth == 0 || s->frames[s->depth - 1].object != object || s->keyed) {
+        cson__fatal("stream has no open %s to end", object ? "object" : "array");
+    }
+    if (s->frames[s->depth - 1].count > 0) cson__dump_newline(&s->w);
+    s->depth--;
+    cson__dump_indent(&s->w, s->depth);
+    cson__writer_putc(&s->w, object ? '}' : ']');
+    if (s->depth == 0) s->done = true;
+}
+
+CSONDEF void cson_stream_begin_object(cson_stream_t *s) {
+    cson__stream_begin(s, true);
+}
+
+CSONDEF void cson_stream_end_object(cson_stream_t *s) {
+    cson__stream_end(s, true);
+}
+
+CSONDEF void cson_stream_begin_array(cson_stream_t *s) {
+    cson__stream_begin(s, false);
+}
+
+CSONDEF void cson_stream_end_array(cson_stream_t *s) {
+    cson__stream_end(s, false);
+}
+
+CSONDEF void cson_stream_key(cson_stream_t *s, const char *key) {
+    if (s->depth == 0 || !s->frames[s->depth - 1].object || s->keyed) cson__fatal("stream expects a value");
+    cson__stream_member(s);
+    if (!key) key = "";
+    cson__writer_putc(&s->w, '"');
+    cson__writer_escaped(&s->w, key, strlen(key));
+    if (s->w.compact) cson__writer_puts(&s->w, "\":");
+    else cson__writer_puts(&s->w, "\": ");
+    s->keyed = true;
+}
+
+CSONDEF void cson_stream_string_n(cson_stream_t *s, const char *value, size_t len) {
+    cson__stream_value(s);
+    cson__writer_putc(&s->w, '"');
+    cson__writer_escaped(&s->w, value, len);
+    cson__writer_putc(&s->w, '"');
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF void cson_stream_string(cson_stream_t *s, const char *value) {
+    if (!value) cson_stream_null(s);
+    else cson_stream_string_n(s, value, strlen(value));
+}
+
+CSONDEF void cson_stream_number(cson_stream_t *s, double value) {
+    cson__stream_value(s);
+    char *buf = cson__writer_reserve(&s->w, 32);
+    s->w.len += cson__format_double(buf, value);
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF void cson_stream_int64(cson_stream_t *s, int64_t value) {
+    cson__stream_value(s);
+    char *buf = cson__writer_reserve(&s->w, 32);
+    s->w.len += cson__format_int64(buf, value);
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF void cson_stream_boolean(cson_stream_t *s, bool value) {
+    cson__stream_value(s);
+    if (value) cson__writer_puts(&s->w, "true");
+    else cson__writer_puts(&s->w, "false");
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF void cson_stream_null(cson_stream_t *s) {
+    cson__stream_value(s);
+    cson__writer_puts(&s->w, "null");
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF void cson_stream_node(cson_stream_t *s, const cson_node_t *node) {
+    cson__stream_value(s);
+    s->w.level = s->depth;
+    cson__dump(&s->w, node);
+    s->w.level = 0;
+    cson__stream_scalar_done(s);
+}
+
+CSONDEF bool cson_stream_close(cson_stream_t *s) {
+    cson__writer_flush(&s->w);
+    bool ok = !s->w.failed && s->done;
+    cson__free(s->w.buf);
+    cson__free(s->w.frames);
+    cson__free(s->frames);
+    cson__free(s);
+    return ok;
+}
+
+// cson__free_scalar - release the key and string of a node
+// @node: node, leaf or container
+static void cson__free_scalar(cson_node_t *node) {
+    if (node->flags & CSON_FLAG_BORROWED) return;
+    if (node->key && !(node->flags & CSON_FLAG_KEY_INTERNED)) cson__free(node->key);
+    if (node->kind == CSON_STRING && !(node->flags & CSON_FLAG_INLINE)) cson__free(node->as.string);
+}
+
+CSONDEF void cson_free(cson_node_t *root) {
+    if (!root) return;
+    if (root->flags & CSON_FLAG_ARENA) return;
+    cson__free_scalar(root);
+    if (root->kind != CSON_OBJECT && root->kind != CSON_ARRAY) return;
+
+    // walk down without a stack: a container being freed keeps its parent in
+    // its key, which is already released, and the next child index in its cap
+    root->key = NULL;
+    root->as.container.cap = 0;
+    cson_node_t *node = root;
+    while (node) {
+        cson_nodes_t *da = &node->as.container;
+        if (da->cap < da->len) {
+            cson_node_t *child = &da->items[da->cap++];
+            if (child->flags & CSON_FLAG_ARENA) continue;
+            cson__free_scalar(child);
+            if ((child->kind == CSON_OBJECT || child->kind == CSON_ARRAY) && child->as.container.len > 0) {
+                child->key = (char *) node;
+                child->as.container.cap = 0;
+                node = child;
+            } else if (child->kind == CSON_OBJECT || child->kind == CSON_ARRAY) {
+                cson__free(child->as.container.items);
+            }
+            continue;
+        }
+        cson__free(da->items);
+        node = (cson_node_t *) node->key;
+    }
+}
+
+// cson__object_find - find the member of an object
+// @root: object node, already materialized
+// @key: member key
+// @hash: cson__hash of key, only read if root is indexed
+// Return: the node pointer, NULL if not exists
+static cson_node_t *cson__object_find(const cson_node_t *root, const char *key, uint32_t hash) {
+    const cson_nodes_t *da = &root->as.container;
+    if (root->flags & CSON_FLAG_INDEXED) {
+        long pos = cson__index_find(da, key, hash);
+        return pos < 0 ? NULL : &da->items[cson__index_of(da)[pos].idx - 1];
+    }
+    for (size_t i = 0; i < da->len; i++) {
+        cson_node_t *node = &da->items[i];
+        if (node->key == key || (node->key && strcmp(node->key, key) == 0)) return node;
+    }
+    return NULL;
+}
+
+CSONDEF cson_node_t *cson_query(const cson_node_t *root, const char *key) {
+    if (root->kind != CSON_OBJECT) cson__fatal("query node should be an object");
+    if (!key) return NULL;
+    if (root->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) root);
+    uint32_t hash = root->flags & CSON_FLAG_INDEXED ? cson__hash(key, strlen(key)) : 0;
+    return cson__object_find(root, key, hash);
+}
+
+CSONDEF cson_nodes_t cson_to_object(const cson_node_t *node) {
+    if (node->kind != CSON_OBJECT) cson__fatal("should be an object node");
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+    return node->as.container;
+}
+
+CSONDEF cson_nodes_t cson_to_array(const cson_node_t *node) {
+    if (node->kind != CSON_ARRAY) cson__fatal("should be an array node");
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+    return node->as.container;
+}
+
+CSONDEF double cson_to_number(const cson_node_t *node) {
+    if (node->kind != CSON_NUMBER) cson__fatal("should be an number node");
+    if (node->flags & CSON_FLAG_INTEGER) return (double) node->as.integer;
+    return node->as.number;
+}
+
+CSONDEF int64_t cson_to_int64(const cson_node_t *node) {
+    if (node->kind != CSON_NUMBER) cson__fatal("should be an number node");
+    if (node->flags & CSON_FLAG_INTEGER) return node->as.integer;
+    double value = node->as.number;
+    if (value != value) return 0;
+    if (value >= 9223372036854775807.0) return INT64_MAX;
+    if (value <= -9223372036854775808.0) return INT64_MIN;
+    return (int64_t) value;
+}
+
+CSONDEF bool cson_to_boolean(const cson_node_t *node) {
+    if (node->kind != CSON_BOOLEAN) cson__fatal("should be an boolean node");
+    return node->as.boolean;
+}
+
+CSONDEF const char *cson_to_string(const cson_node_t *node) {
+    if (node->kind != CSON_STRING) cson__fatal("should be an string node");
+    if (node->flags & CSON_FLAG_INLINE) return node->as.small;
+    return node->as.string;
+}
+
+// cson__container_erase - remove one item and release it
+// @node: materialized object or array
+// @idx: item index
+// Note: the items behind idx move down, so the order is kept
+static void cson__container_erase(cson_node_t *node, size_t idx) {
+    cson_nodes_t *da = &node->as.container;
+    cson_node_t removed = da->items[idx];
+    if (node->flags & CSON_FLAG_INDEXED) cson__index_remove(da, idx);
+    memmove(da->items + idx, da->items + idx + 1, sizeof(cson_node_t)*(da->len - idx - 1));
+    da->len--;
+    cson_free(&removed);
+}
+
+CSONDEF void cson_remove_with_key(cson_node_t *node, const char *key) {
+    if (node->kind != CSON_OBJECT) cson__fatal("should be an object node");
+    if (node->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    cson_node_t *removed_node = cson_query(node, key);
+    if (!removed_node) return;
+    cson__container_erase(node, (size_t) (removed_node - node->as.container.items));
+}
+
+CSONDEF void cson_remove_with_idx(cson_node_t *node, size_t idx) {
+    if (node->kind != CSON_ARRAY) cson__fatal("should be an array node");
+    if (node->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize(node);
+    if (idx >= node->as.container.len) cson__fatal("index out of range");
+    cson__container_erase(node, idx);
+}
+
+CSONDEF size_t cson_remove_if(cson_node_t *node, cson_pred_t pred, void *user) {
+    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
+        cson__fatal("should be an object or array node");
+    }
+    if (node->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize(node);
+    cson_nodes_t *da = &node->as.container;
+    size_t kept = 0;
+    for (size_t i = 0; i < da->len; i++) {
+        if (pred(user, &da->items[i])) {
+            cson_free(&da->items[i]);
+        } else {
+            if (kept != i) da->items[kept] = da->items[i];
+            kept++;
+        }
+    }
+    size_t removed = da->len - kept;
+    da->len = (uint32_t) kept;
+    if (removed && (node->flags & CSON_FLAG_INDEXED)) cson__index_build(da);
+    return removed;
+}
+
+CSONDEF void cson_remove_all(cson_node_t *node) {
+    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
+        cson__fatal("should be an object or array node");
+    }
+    if (node->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (node->flags & CSON_FLAG_LAZY) cson__materialize(node);
+    for (size_t i = 0; i < node->as.container.len; i++) cson_free(&node->as.container.items[i]);
+    node->as.container.len = 0;
+    if (node->flags & CSON_FLAG_INDEXED) cson__index_build(&node->as.container);
+}
 
-    char ch = *lex->start;
-    if (ch == '\0')  return cson__make_eof(lex);
-    if (isdigit(ch)) return cson__make_number(lex);
-    if (ch == '"')   return cson__make_string(lex);
-    if (isalpha(ch)) return cson__make_literal(lex);
-    switch (ch) {
-    case '{': return cson__make_punc(lex, CSON_TK_LCURLY);
-    case '}': return cson__make_punc(lex, CSON_TK_RCURLY);
-    case '[': return cson__make_punc(lex, CSON_TK_LSQUARE);
-    case ']': return cson__make_punc(lex, CSON_TK_RSQUARE);
-    case ':': return cson__make_punc(lex, CSON_TK_COLON);
-    case ',': return cson__make_punc(lex, CSON_TK_COMMA);
-    case '"': return cson__make_string(lex);
-    default: cson__fatal("unknown character: %c", ch);
+// cson__path_index - read an array index step
+// @s: step text
+// @len: step length
+// Return: index, SIZE_MAX if the text is not a canonical number
+static size_t cson__path_index(const char *s, size_t len) {
+    if (len == 0 || (len > 1 && s[0] == '0')) return SIZE_MAX;
+    size_t idx = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!cson__is_digit(s[i])) return SIZE_MAX;
+        size_t digit = (size_t) (s[i] - '0');
+        if (idx > (SIZE_MAX - 1 - digit)/10) return SIZE_MAX;
+        idx = 10*idx + digit;
     }
+    return idx;
 }
 
-// cson__match - get a token and check the kind
-// @lex: pointer to lexer
-// @kind: expected kind
-// Note: if it is unexpected, just abort
-// Return: the expected token
-static cson_token_t cson__match(cson_lexer_t *lex, cson_token_kind_t kind) {
-    cson_token_t token = cson__get_next_token(lex);
-    if (token.kind != kind) cson__fatal("expect %d, but got %d at '%.*s'",
-                                       kind, token.kind, (int) token.len, token.start);
-    return token;
+// cson__path_push - append a step to a path
+// @path: path being compiled
+// @key: key text, already unescaped (Nullable, then idx must be set)
+// @len: key length
+// @idx: array index, SIZE_MAX if none
+static void cson__path_push(cson_path_t *path, char *key, size_t len, size_t idx) {
+    path->steps = (cson_path_step_t *) cson__realloc(path->steps, sizeof(cson_path_step_t)*(path->len + 1));
+    cson_path_step_t *step = &path->steps[path->len++];
+    step->key = key;
+    step->len = len;
+    step->hash = key ? cson__hash(key, len) : 0;
+    step->idx = idx;
 }
 
-// cson__peek - peek current token
-// @lex: pointer to lexer
-// Note: not consume current token
-// Return current token
-static cson_token_t cson__peek(cson_lexer_t *lex) {
-    cson_lexer_t lex_copy = *lex;
-    cson_token_t token = cson__get_next_token(&lex_copy);
-    return token;
+// cson__path_pointer - compile a JSON Pointer
+// @path: path being compiled
+// @s: pointer text, starts with '/'
+// Note: "~1" stands for '/' and "~0" for '~' in a reference token
+static void cson__path_pointer(cson_path_t *path, const char *s) {
+    while (*s == '/') {
+        const char *start = ++s;
+        while (*s && *s != '/') s++;
+        char *key = (char *) cson__malloc((size_t) (s - start) + 1);
+        size_t len = 0;
+        for (const char *p = start; p < s; p++) {
+            if (*p != '~') {
+                key[len++] = *p;
+                continue;
+            }
+            p++;
+            if (p == s || (*p != '0' && *p != '1')) {
+                cson__free(key);
+                cson__fatal("invalid escape in json pointer '%s'", start - 1);
+            }
+            key[len++] = *p == '0' ? '~' : '/';
+        }
+        key[len] = '\0';
+        cson__path_push(path, key, len, cson__path_index(key, len));
+    }
 }
 
-// cson__strndup - strndup
-// @s: original string (Nullable)
-// @len: duplicate length
-// Note: C99 not support strndup
-// Return: duplicate string
-static char *cson__strndup(const char *s, size_t len) {
-    if (!s) return NULL;
-    char *p = (char *) malloc(len + 1);
-    if (!p) cson__fatal("out of memeory");
-    memcpy(p, s, len);
-    p[len] = '\0';
-    return p;
+// cson__path_dotted - compile a dotted path
+// @path: path being compiled
+// @s: dotted path text, steps are separated by '.' and may end with "[n]" indexes
+static void cson__path_dotted(cson_path_t *path, const char *s) {
+    const char *full = s;
+    while (1) {
+        const char *start = s;
+        while (*s && *s != '.' && *s != '[') s++;
+        size_t len = (size_t) (s - start);
+        if (len > 0) {
+            cson__path_push(path, cson__strndup(start, len), len, cson__path_index(start, len));
+        } else if (*s != '[') {
+            cson__fatal("empty step in path '%s'", full);
+        }
+        while (*s == '[') {
+            const char *digits = ++s;
+            while (cson__is_digit(*s)) s++;
+            size_t idx = cson__path_index(digits, (size_t) (s - digits));
+            if (*s != ']' || idx == SIZE_MAX) cson__fatal("invalid index in path '%s'", full);
+            s++;
+            cson__path_push(path, NULL, 0, idx);
+        }
+        if (!*s) return;
+        if (*s != '.') cson__fatal("unexpected '%c' in path '%s'", *s, full);
+        s++;
+    }
 }
 
-static cson_node_t cson__parse_object(cson_lexer_t *lex);
-static cson_node_t cson__parse_array(cson_lexer_t *lex);
+CSONDEF cson_path_t cson_path_compile(const char *path) {
+    cson_path_t compiled;
+    memset(&compiled, 0, sizeof(compiled));
+    if (path[0] == '/') cson__path_pointer(&compiled, path);
+    else if (path[0]) cson__path_dotted(&compiled, path);
+    return compiled;
+}
 
-// cson__parse_value - parse json value
-// @lex: pointer to lexer
-// Note: abort if failed to parse value, and the result will be append to container,
-//       so it do not need to its pointer, otherwise there would be duplicate nodes
-// Return: value node without key yet
-static cson_node_t cson__parse_value(cson_lexer_t *lex) {
-    cson_node_t node;
-    memset(&node, 0, sizeof(node));
-    cson_token_t token = cson__get_next_token(lex);
+CSONDEF cson_node_t *cson_path_eval(const cson_path_t *path, const cson_node_t *root) {
+    const cson_node_t *node = root;
+    for (size_t i = 0; node && i < path->len; i++) {
+        const cson_path_step_t *step = &path->steps[i];
+        if (node->kind == CSON_OBJECT && step->key) {
+            if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+            node = cson__object_find(node, step->key, step->hash);
+        } else if (node->kind == CSON_ARRAY && step->idx != SIZE_MAX) {
+            if (node->flags & CSON_FLAG_LAZY) cson__materialize((cson_node_t *) node);
+            node = step->idx < node->as.container.len ? &node->as.container.items[step->idx] : NULL;
+        } else {
+            node = NULL;
+        }
+    }
+    return (cson_node_t *) node;
+}
 
-    switch (token.kind) {
-    case CSON_TK_NULL:
-        node.kind = CSON_NULL;
-        break;
-    case CSON_TK_NUMBER: {
-        node.kind = CSON_NUMBER;
-        char buffer[token.len + 1];
-        memcpy(buffer, token.start, token.len);
-        buffer[token.len] = '\0';
-        node.as.number = strtod(buffer, NULL);
-    } break;
-    case CSON_TK_TRUE:
-        node.kind = CSON_BOOLEAN;
-        node.as.boolean = true;
-        break;
-    case CSON_TK_FALSE:
-        node.kind = CSON_BOOLEAN;
-        node.as.boolean = false;
-        break;
-    case CSON_TK_STRING:
-        node.kind = CSON_STRING;
-        node.as.string = cson__strndup(token.start, token.len);
-        break;
-    case CSON_TK_LCURLY:
-        node = cson__parse_object(lex);
-        break;
-    case CSON_TK_LSQUARE:
-        node = cson__parse_array(lex);
-        break;
-    default: cson__fatal("unreachable");
+CSONDEF cson_tape_ref_t cson_tape_path_eval(const cson_path_t *path, cson_tape_ref_t root) {
+    cson_tape_ref_t ref = root;
+    for (size_t i = 0; ref.tape && i < path->len; i++) {
+        const cson_path_step_t *step = &path->steps[i];
+        unsigned char tag = CSON__TAPE_TAG(ref.tape->words[ref.idx]);
+        if (tag == '{' && step->key) {
+            cson_tape_ref_t m = cson_tape_first(ref);
+            for (; m.tape; m = cson_tape_next(m)) {
+                size_t n;
+                const char *key = cson__tape_text(m.tape, m.tape->words[m.key], &n);
+                if (n == step->len && memcmp(key, step->key, n) == 0) break;
+            }
+            ref = m;
+        } else if (tag == '[' && step->idx != SIZE_MAX) {
+            ref = cson_tape_at(ref, step->idx);
+        } else {
+            ref.tape = NULL;
+        }
     }
+    return ref;
+}
 
-    return node;
+CSONDEF void cson_path_free(cson_path_t *path) {
+    if (!path) return;
+    for (size_t i = 0; i < path->len; i++) cson__free(path->steps[i].key);
+    cson__free(path->steps);
+    memset(path, 0, sizeof(*path));
 }
 
-// cson__parse_pair - parse json pair
-// @lex: pointer to lexer
-// Note: abort if failed to parse pair, and the result will be append to container,
-//       so it do not need to its pointer, otherwise there would be duplicate nodes
-// Return: pair node
-static cson_node_t cson__parse_pair(cson_lexer_t *lex) {
-    cson_token_t key = cson__match(lex, CSON_TK_STRING);
-    cson__match(lex, CSON_TK_COLON);
-    cson_node_t node = cson__parse_value(lex);
-    node.key = cson__strndup(key.start, key.len);
+CSONDEF cson_node_t *cson_query_path(const cson_node_t *root, const char *path) {
+    cson_path_t compiled = cson_path_compile(path);
+    cson_node_t *node = cson_path_eval(&compiled, root);
+    cson_path_free(&compiled);
     return node;
 }
 
-// cson__parse_obejct - parse json array
-// @lex: pointer to lexer
-// Return: array node
-static cson_node_t cson__parse_array(cson_lexer_t *lex) {
-    cson_node_t node = cson_create_array(NULL);
-    while (1) {
-        cson_token_t token = cson__peek(lex);
-        if (token.kind == CSON_TK_RSQUARE) {
-            break;
-        } else if (token.kind == CSON_TK_COMMA) {
-            cson__get_next_token(lex);
-            continue;
-        }
-        cson_node_t value_node = cson__parse_value(lex);
-        cson_append(&node, value_node);
+// cson__clone - deep copy a node under another key
+// @node: original node
+// @key: key of the copy (Nullable)
+// Return: heap copy
+static cson_node_t cson__clone(const cson_node_t *node, const char *key) {
+    cson_node_t copy = cson__create_node(node->kind, key);
+    copy.flags = node->flags & (CSON_FLAG_INTEGER | CSON_FLAG_INLINE);
+    if (node->kind == CSON_STRING) {
+        const char *s = cson_to_string(node);
+        if (node->flags & CSON_FLAG_INLINE) memcpy(copy.as.small, s, sizeof(copy.as.small));
+        else copy.as.string = s ? cson__strndup(s, strlen(s)) : NULL;
+    } else if (node->kind == CSON_OBJECT || node->kind == CSON_ARRAY) {
+        cson_nodes_t da = node->kind == CSON_OBJECT ? cson_to_object(node) : cson_to_array(node);
+        if (da.len == 0) return copy;
+        cson__container_reserve(&copy, da.len);
+        for (size_t i = 0; i < da.len; i++) copy.as.container.items[i] = cson__clone(&da.items[i], da.items[i].key);
+        copy.as.container.len = da.len;
+        if (copy.flags & CSON_FLAG_INDEXED) cson__index_build(&copy.as.container);
+    } else {
+        copy.as = node->as;
     }
-    cson__match(lex, CSON_TK_RSQUARE);
-    return node;
+    return copy;
 }
 
-// cson__parse_obejct - parse json object
-// @lex: pointer to lexer
-// Return: object node
-static cson_node_t cson__parse_object(cson_lexer_t *lex) {
-    cson_node_t node = cson_create_object(NULL);
-    while (1) {
-        cson_token_t token = cson__peek(lex);
-        if (token.kind == CSON_TK_RCURLY) {
-            break;
-        } else if (token.kind == CSON_TK_COMMA) {
-            cson__get_next_token(lex);
-            continue;
-        }
-        cson_node_t pair_node = cson__parse_pair(lex);
-        cson_append(&node, pair_node);
-    }
-    cson__match(lex, CSON_TK_RCURLY);
-    return node;
+CSONDEF cson_node_t cson_clone(const cson_node_t *node) {
+    return cson__clone(node, node->key);
 }
 
-// cson__create_container - create a container node
-// @kind: node type
-// @key: member key (Nullable)
-// Return: object or array node (always valid)
-static cson_node_t cson_create_container(cson_node_kind_t kind, const char *key) {
-    cson_node_t node;
-    memset(&node, 0, sizeof(node));
-    node.kind = kind;
-    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
-    return node;
+// cson__assign - replace the value of a node, keeping its key
+// @target: node to overwrite
+// @value: new value, may live inside target
+static void cson__assign(cson_node_t *target, const cson_node_t *value) {
+    cson_node_t copy = cson__clone(value, target->key);
+    cson_free(target);
+    *target = copy;
 }
 
-CSONDEF cson_node_t cson_create_object(const char *key) {
-    return cson_create_container(CSON_OBJECT, key);
+// cson__equal - compare two values the way json does
+// @a: first node
+// @b: second node
+// Note: object members are matched by key in any order, numbers by value
+// Return: true if equal
+static bool cson__equal(const cson_node_t *a, const cson_node_t *b) {
+    if (a->kind != b->kind) return false;
+    switch (a->kind) {
+    case CSON_NULL: return true;
+    case CSON_BOOLEAN: return a->as.boolean == b->as.boolean;
+    case CSON_NUMBER:
+        if ((a->flags & b->flags) & CSON_FLAG_INTEGER) return a->as.integer == b->as.integer;
+        return cson_to_number(a) == cson_to_number(b);
+    case CSON_STRING: {
+        const char *x = cson_to_string(a), *y = cson_to_string(b);
+        return strcmp(x ? x : "", y ? y : "") == 0;
+    }
+    case CSON_ARRAY: {
+        cson_nodes_t x = cson_to_array(a), y = cson_to_array(b);
+        if (x.len != y.len) return false;
+        for (size_t i = 0; i < x.len; i++) {
+            if (!cson__equal(&x.items[i], &y.items[i])) return false;
+        }
+        return true;
+    }
+    case CSON_OBJECT: {
+        cson_nodes_t x = cson_to_object(a), y = cson_to_object(b);
+        if (x.len != y.len) return false;
+        for (size_t i = 0; i < x.len; i++) {
+            const cson_node_t *other = cson_query(b, x.items[i].key);
+            if (!other || !cson__equal(&x.items[i], other)) return false;
+        }
+        return true;
+    }
+    }
+    return false;
 }
 
-CSONDEF cson_node_t cson_create_array(const char *key) {
-    return cson_create_container(CSON_ARRAY, key);
+// cson__mix - spread the bits of a hash (splitmix64 finalizer)
+static uint64_t cson__mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
 }
 
-CSONDEF cson_node_t cson_create_number(const char *key, double value) {
-    cson_node_t node;
-    node.kind = CSON_NUMBER;
-    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
-    node.as.number = value;
-    return node;
+// cson__hash64 - 64-bit FNV-1a of a string
+static uint64_t cson__hash64(const char *s) {
+    uint64_t h = 14695981039346656037ull;
+    for (; s && *s; s++) {
+        h ^= (unsigned char) *s;
+        h *= 1099511628211ull;
+    }
+    return h;
 }
 
-CSONDEF cson_node_t cson_create_boolean(const char *key, bool value) {
-    cson_node_t node;
-    node.kind = CSON_BOOLEAN;
-    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
-    node.as.boolean = value;
-    return node;
+// subtree hash of one node
+typedef struct {
+    uint64_t hash;
+    size_t size; // nodes in the subtree, the node itself included
+} cson__digest_t;
+
+typedef struct {
+    cson__digest_t *items;
+    size_t len;
+    size_t cap;
+} cson__digests_t;
+
+// cson__digest - hash every subtree of a tree
+// @node: subtree root
+// @out: digests in pre-order, the children of a container follow it
+// Note: equal values hash equal, object members are summed so their order
+//       does not count, the other way round only holds with high probability
+// Return: hash of node
+static uint64_t cson__digest(const cson_node_t *node, cson__digests_t *out) {
+    if (out->len == out->cap) {
+        out->cap = out->cap ? 2*out->cap : 64;
+        out->items = (cson__digest_t *) cson__realloc(out->items, sizeof(cson__digest_t)*out->cap);
+    }
+    size_t at = out->len++;
+    uint64_t h = (uint64_t) node->kind;
+    if (node->kind == CSON_BOOLEAN) {
+        h ^= node->as.boolean ? 0x10 : 0x20;
+    } else if (node->kind == CSON_NUMBER) {
+        double value = cson_to_number(node);
+        if (value == 0) value = 0; // -0 equals 0
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        h ^= bits;
+    } else if (node->kind == CSON_STRING) {
+        h ^= cson__hash64(cson_to_string(node));
+    } else if (node->kind == CSON_ARRAY) {
+        cson_nodes_t da = cson_to_array(node);
+        for (size_t i = 0; i < da.len; i++) h = cson__mix(h + cson__digest(&da.items[i], out));
+    } else if (node->kind == CSON_OBJECT) {
+        cson_nodes_t da = cson_to_object(node);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < da.len; i++) {
+            uint64_t member = cson__digest(&da.items[i], out);
+            sum += cson__mix(cson__hash64(da.items[i].key) ^ cson__mix(member));
+        }
+        h ^= sum;
+    }
+    h = cson__mix(h);
+    out->items[at].hash = h;
+    out->items[at].size = out->len - at;
+    return h;
 }
 
-CSONDEF cson_node_t cson_create_string(const char *key, const char *value) {
-    cson_node_t node;
-    node.kind = CSON_STRING;
-    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
-    node.as.string = value ? cson__strndup(value, strlen(value)) : NULL;
-    return node;
+typedef struct {
+    cson_node_t patch;       // array of operations, or the merge patch
+    char *path;              // JSON Pointer of the nodes being compared
+    size_t path_len;
+    size_t path_cap;
+    cson__digests_t from;
+    cson__digests_t to;
+    size_t *pos;             // digest positions of the children being compared
+    size_t pos_len;
+    size_t pos_cap;
+} cson__diff_t;
+
+// cson__diff_init - hash both trees
+// @d: diff state
+// @from: old tree
+// @to: new tree
+static void cson__diff_init(cson__diff_t *d, const cson_node_t *from, const cson_node_t *to) {
+    memset(d, 0, sizeof(*d));
+    cson__digest(from, &d->from);
+    cson__digest(to, &d->to);
+    d->path_cap = 64;
+    d->path = (char *) cson__malloc(d->path_cap);
+    d->path[0] = '\0';
 }
 
-CSONDEF cson_node_t cson_create_null(const char *key) {
-    cson_node_t node;
-    node.kind = CSON_NULL;
-    node.key = key ? cson__strndup(key, strlen(key)) : NULL;
-    return node;
+// cson__diff_release - release the scratch memory of a diff
+static void cson__diff_release(cson__diff_t *d) {
+    cson__free(d->from.items);
+    cson__free(d->to.items);
+    cson__free(d->path);
+    cson__free(d->pos);
 }
 
-CSONDEF cson_node_t cson_load_buffer(const char *buffer) {
-    cson_lexer_t lex = { .start = buffer, .current = buffer };
-    // while (1) {
-    //     cson_token_t token = cson__get_next_token(&lex);
-    //     if (token.kind == CSON_TK_EOF) break;
-    //     printf("token: %d, value: %.*s\n", token.kind, (int) token.len, token.start);
-    // }
-    // return NULL;
-    cson__match(&lex, CSON_TK_LCURLY);
-    return cson__parse_object(&lex);
+// cson__diff_same - check that two subtrees are equal
+// @ai: digest position of a in the old tree
+// @bi: digest position of b in the new tree
+// Note: different hashes settle it without walking the subtrees
+static bool cson__diff_same(const cson__diff_t *d, const cson_node_t *a, size_t ai,
+                            const cson_node_t *b, size_t bi) {
+    return d->from.items[ai].hash == d->to.items[bi].hash && cson__equal(a, b);
 }
 
-CSONDEF cson_node_t cson_load_file(const char *path) {
-    char *buffer = cson__read_file(path);
-    if (!buffer) cson__fatal("empty file or error occurs when reading file");
-    cson_node_t root = cson_load_buffer(buffer);
-    free(buffer);
-    return root;
+// cson__diff_positions - push the digest positions of the children of a container
+// @d: diff state
+// @digests: digests of the tree the container belongs to
+// @da: materialized children
+// @first: digest position of the first child
+// Return: stack base, pop with d->pos_len = base
+static size_t cson__diff_positions(cson__diff_t *d, const cson__digests_t *digests,
+                                   cson_nodes_t da, size_t first) {
+    size_t base = d->pos_len;
+    if (d->pos_len + da.len > d->pos_cap) {
+        while (d->pos_len + da.len > d->pos_cap) d->pos_cap = d->pos_cap ? 2*d->pos_cap : 64;
+        d->pos = (size_t *) cson__realloc(d->pos, sizeof(size_t)*d->pos_cap);
+    }
+    for (size_t i = 0; i < da.len; i++) {
+        d->pos[d->pos_len++] = first;
+        first += digests->items[first].size;
+    }
+    return base;
 }
 
-static void cson__dump_value(const cson_node_t *node, FILE *f, size_t level, bool indent);
-static void cson__dump_indent(FILE *f, size_t level);
+// cson__diff_push - append a reference token to the current path
+// @d: diff state
+// @key: member key, '~' and '/' are escaped (Nullable, then idx is used)
+// @idx: array index
+// Return: previous path length, restore it with cson__diff_pop
+static size_t cson__diff_push(cson__diff_t *d, const char *key, size_t idx) {
+    size_t mark = d->path_len;
+    size_t need = d->path_len + (key ? 2*strlen(key) : 24) + 2;
+    if (need > d->path_cap) {
+        while (need > d->path_cap) d->path_cap *= 2;
+        d->path = (char *) cson__realloc(d->path, d->path_cap);
+    }
+    char *s = d->path + d->path_len;
+    *s++ = '/';
+    if (key) {
+        for (; *key; key++) {
+            if (*key == '~') *s++ = '~', *s++ = '0';
+            else if (*key == '/') *s++ = '~', *s++ = '1';
+            else *s++ = *key;
+        }
+        *s = '\0';
+    } else {
+        s += snprintf(s, 24, "%zu", idx);
+    }
+    d->path_len = (size_t) (s - d->path);
+    return mark;
+}
 
-// cson__dump_pair - output pair (key and value)
-// @node: current node
-// @f: output file pointer
-// @level: indent level
-// @comma: write comma or not
-static void cson__dump_pair(const cson_node_t *node, FILE *f, size_t level, bool comma) {
-    cson__dump_indent(f, level);
-    fprintf(f, "\"%s\": ", node->key);
-    cson__dump_value(node, f, level, false);
-    if (comma) fprintf(f, ",\n");
-    else fprintf(f, "\n");
+static void cson__diff_pop(cson__diff_t *d, size_t mark) {
+    d->path_len = mark;
+    d->path[mark] = '\0';
 }
 
-// cson__dump_value - output value
-// @node: current node
-// @f: output file pointer
-// @indent: write indent or not
-static void cson__dump_value(const cson_node_t *node, FILE *f, size_t level, bool indent) {
-    if (indent) cson__dump_indent(f, level);
+// cson__diff_emit - append an operation on the current path
+// @d: diff state
+// @op: operation name
+// @value: value to copy into the operation (Nullable)
+static void cson__diff_emit(cson__diff_t *d, const char *op, const cson_node_t *value) {
+    cson_node_t *item = cson_append_new(&d->patch, CSON_OBJECT, NULL);
+    cson_append(item, cson_create_string_ref("op", op));
+    cson_append(item, cson_create_string("path", d->path));
+    if (value) cson_append(item, cson__clone(value, "value"));
+}
 
-    switch (node->kind) {
-    case CSON_OBJECT:
-        fprintf(f, "{\n");
-        for (size_t i = 0; i < node->as.container.len; i++) {
-            cson_node_t *subnode = &node->as.container.items[i];
-            bool comma = true;
-            if (i == node->as.container.len - 1) comma = false;
-            cson__dump_pair(subnode, f, level + 1, comma);
-        }
-        cson__dump_indent(f, level);
-        fprintf(f, "}");
-        break;
+// cson__diff_node - emit the operations that turn one subtree into another
+// @d: diff state, path points at a
+// @a: old subtree
+// @ai: digest position of a
+// @b: new subtree
+// @bi: digest position of b
+static void cson__diff_node(cson__diff_t *d, const cson_node_t *a, size_t ai,
+                            const cson_node_t *b, size_t bi) {
+    if (cson__diff_same(d, a, ai, b, bi)) return;
+    if (a->kind != b->kind || (a->kind != CSON_OBJECT && a->kind != CSON_ARRAY)) {
+        cson__diff_emit(d, "replace", b);
+        return;
+    }
 
-    case CSON_ARRAY:
-        fprintf(f, "[\n");
-        for (size_t i = 0; i < node->as.container.len; i++) {
-            cson_node_t *subnode = &node->as.container.items[i];
-            cson__dump_value(subnode, f, level + 1, true);
-            if (i == node->as.container.len - 1) fprintf(f, "\n");
-            else fprintf(f, ",\n");
+    if (a->kind == CSON_OBJECT) {
+        cson_nodes_t x = cson_to_object(a), y = cson_to_object(b);
+        size_t base = cson__diff_positions(d, &d->to, y, bi + 1);
+        size_t p = ai + 1;
+        for (size_t i = 0; i < x.len; i++) {
+            const cson_node_t *item = &x.items[i];
+            const cson_node_t *other = cson_query(b, item->key);
+            size_t mark = cson__diff_push(d, item->key ? item->key : "", 0);
+            if (!other) cson__diff_emit(d, "remove", NULL);
+            else cson__diff_node(d, item, p, other, d->pos[base + (size_t) (other - y.items)]);
+            cson__diff_pop(d, mark);
+            p += d->from.items[p].size;
         }
-        cson__dump_indent(f, level);
-        fprintf(f, "]");
-        break;
+        for (size_t i = 0; i < y.len; i++) {
+            if (cson_query(a, y.items[i].key)) continue;
+            size_t mark = cson__diff_push(d, y.items[i].key ? y.items[i].key : "", 0);
+            cson__diff_emit(d, "add", &y.items[i]);
+            cson__diff_pop(d, mark);
+        }
+        d->pos_len = base;
+        return;
+    }
 
-    case CSON_STRING:
-        fprintf(f, "\"");
-        fprintf(f, node->as.string);
-        fprintf(f, "\"");
-        break;
+    cson_nodes_t x = cson_to_array(a), y = cson_to_array(b);
+    size_t xs = cson__diff_positions(d, &d->from, x, ai + 1);
+    size_t ys = cson__diff_positions(d, &d->to, y, bi + 1);
+    size_t n = x.len < y.len ? x.len : y.len, head = 0, tail = 0;
+    while (head < n && cson__diff_same(d, &x.items[head], d->pos[xs + head], &y.items[head], d->pos[ys + head])) {
+        head++;
+    }
+    while (tail < n - head) {
+        size_t i = x.len - 1 - tail, j = y.len - 1 - tail;
+        if (!cson__diff_same(d, &x.items[i], d->pos[xs + i], &y.items[j], d->pos[ys + j])) break;
+        tail++;
+    }
+    size_t xn = x.len - head - tail, yn = y.len - head - tail, k = xn < yn ? xn : yn;
+    for (size_t i = head; i < head + k; i++) {
+        size_t mark = cson__diff_push(d, NULL, i);
+        cson__diff_node(d, &x.items[i], d->pos[xs + i], &y.items[i], d->pos[ys + i]);
+        cson__diff_pop(d, mark);
+    }
+    for (size_t i = head + xn; i-- > head + k;) {
+        size_t mark = cson__diff_push(d, NULL, i);
+        cson__diff_emit(d, "remove", NULL);
+        cson__diff_pop(d, mark);
+    }
+    for (size_t i = head + k; i < head + yn; i++) {
+        size_t mark = cson__diff_push(d, NULL, i);
+        cson__diff_emit(d, "add", &y.items[i]);
+        cson__diff_pop(d, mark);
+    }
+    d->pos_len = xs;
+}
 
-    case CSON_NUMBER:
-        fprintf(f, "%.15g", node->as.number);
-        break;
+CSONDEF cson_node_t cson_diff(const cson_node_t *from, const cson_node_t *to) {
+    cson__diff_t d;
+    cson__diff_init(&d, from, to);
+    d.patch = cson_create_array(NULL);
+    cson__diff_node(&d, from, 0, to, 0);
+    cson__diff_release(&d);
+    return d.patch;
+}
 
-    case CSON_BOOLEAN:
-        if (node->as.boolean) fprintf(f, "true");
-        else fprintf(f, "false");
-        break;
+// cson__pointer_valid - check a JSON Pointer of a patch operation
+// @s: pointer text
+// Return: true if it is empty or made of '/' tokens with valid escapes
+static bool cson__pointer_valid(const char *s) {
+    if (*s && *s != '/') return false;
+    for (; *s; s++) {
+        if (*s == '~' && s[1] != '0' && s[1] != '1') return false;
+    }
+    return true;
+}
 
-    case CSON_NULL:
-        fprintf(f, "null");
-        break;
+// cson__patch_member - get a string member of a patch operation
+// @op: operation object
+// @key: member key
+// Return: string, NULL if missing or not a string
+static const char *cson__patch_member(const cson_node_t *op, const char *key) {
+    const cson_node_t *node = cson_query(op, key);
+    return node && node->kind == CSON_STRING ? cson_to_string(node) : NULL;
+}
 
-    default:
-        break;
+// cson__patch_parent - find the container a pointer ends in
+// @root: patched tree
+// @path: compiled pointer with at least one step
+// Return: parent node, NULL if not exists
+static cson_node_t *cson__patch_parent(cson_node_t *root, cson_path_t *path) {
+    path->len--;
+    cson_node_t *parent = cson_path_eval(path, root);
+    path->len++;
+    return parent;
+}
+
+// cson__patch_add - add a value at a pointer
+// @root: patched tree
+// @pointer: valid JSON Pointer
+// @value: heap value without key, released here on failure
+// Return: false if the parent does not exist or the index is out of range
+static bool cson__patch_add(cson_node_t *root, const char *pointer, cson_node_t value) {
+    cson_path_t path = cson_path_compile(pointer);
+    bool ok = false;
+    if (path.len == 0) {
+        cson_free(root);
+        *root = value;
+        cson_path_free(&path);
+        return true;
+    }
+    cson_node_t *parent = cson__patch_parent(root, &path);
+    const cson_path_step_t *last = &path.steps[path.len - 1];
+    if (parent && parent->kind == CSON_OBJECT) {
+        cson_node_t *existing = cson_query(parent, last->key);
+        value.key = cson__strndup(last->key, last->len);
+        if (existing) {
+            cson_free(existing);
+            *existing = value;
+        } else {
+            cson_append(parent, value);
+        }
+        ok = true;
+    } else if (parent && parent->kind == CSON_ARRAY) {
+        cson_nodes_t *da = &parent->as.container;
+        size_t len = cson_to_array(parent).len;
+        size_t idx = strcmp(last->key, "-") == 0 ? len : last->idx;
+        if (idx <= len) {
+            cson__container_check(parent);
+            cson__container_reserve(parent, (size_t) da->len + 1);
+            memmove(da->items + idx + 1, da->items + idx, sizeof(cson_node_t)*(da->len - idx));
+            da->items[idx] = value;
+            da->len++;
+            ok = true;
+        }
     }
+    if (!ok) cson_free(&value);
+    cson_path_free(&path);
+    return ok;
 }
 
-// cson__dump_indent - output indent with level
-// @f: output file pointer
-// @level: current level
-static void cson__dump_indent(FILE *f, size_t level) {
-    const char *indent = "    ";
-    for (size_t i = 0; i < level; i++) {
-        fprintf(f, indent);
+// cson__patch_remove - remove the value at a pointer
+// @root: patched tree
+// @pointer: valid JSON Pointer
+// Return: false if there is no such value or it is the root
+static bool cson__patch_remove(cson_node_t *root, const char *pointer) {
+    cson_path_t path = cson_path_compile(pointer);
+    bool ok = false;
+    cson_node_t *parent = path.len ? cson__patch_parent(root, &path) : NULL;
+    const cson_path_step_t *last = path.len ? &path.steps[path.len - 1] : NULL;
+    if (parent && parent->kind == CSON_OBJECT && cson_query(parent, last->key)) {
+        cson_remove_with_key(parent, last->key);
+        ok = true;
+    } else if (parent && parent->kind == CSON_ARRAY && last->idx < cson_to_array(parent).len) {
+        cson_remove_with_idx(parent, last->idx);
+        ok = true;
     }
+    cson_path_free(&path);
+    return ok;
 }
 
-CSONDEF void cson_write(const cson_node_t *root, FILE *f) {
-    cson__dump_value(root, f, 0, true);
+// cson__patch_op - apply one JSON Patch operation
+// @root: patched tree
+// @op: operation object
+// Return: true if applied
+static bool cson__patch_op(cson_node_t *root, const cson_node_t *op) {
+    if (op->kind != CSON_OBJECT) return false;
+    const char *name = cson__patch_member(op, "op");
+    const char *path = cson__patch_member(op, "path");
+    const char *from = cson__patch_member(op, "from");
+    const cson_node_t *value = cson_query(op, "value");
+    if (!name || !path || !cson__pointer_valid(path)) return false;
+    if (from && !cson__pointer_valid(from)) return false;
+
+    if (strcmp(name, "add") == 0) {
+        return value && cson__patch_add(root, path, cson__clone(value, NULL));
+    } else if (strcmp(name, "remove") == 0) {
+        return cson__patch_remove(root, path);
+    } else if (strcmp(name, "replace") == 0) {
+        cson_node_t *target = cson_query_path(root, path);
+        if (!target || !value) return false;
+        cson__assign(target, value);
+        return true;
+    } else if (strcmp(name, "test") == 0) {
+        cson_node_t *target = cson_query_path(root, path);
+        return target && value && cson__equal(target, value);
+    } else if (strcmp(name, "move") == 0 || strcmp(name, "copy") == 0) {
+        if (!from) return false;
+        cson_node_t *source = cson_query_path(root, from);
+        if (!source) return false;
+        if (name[0] == 'c') return cson__patch_add(root, path, cson__clone(source, NULL));
+        size_t len = strlen(from);
+        if (strcmp(from, path) == 0) return true;
+        if (strncmp(from, path, len) == 0 && path[len] == '/') return false;
+        cson_node_t moved = cson__clone(source, NULL);
+        cson__patch_remove(root, from);
+        return cson__patch_add(root, path, moved);
+    }
+    return false;
 }
 
-CSONDEF void cson_generate_file(const cson_node_t *root, const char *path) {
-    FILE *f = fopen(path, "w");
-    if (!f) cson__fatal("failed to open file '%s'", path);
-    cson_write(root, f);
-    fclose(f);
+CSONDEF bool cson_patch_apply(cson_node_t *root, const cson_node_t *patch) {
+    if (root->flags & CSON_FLAG_ARENA) cson__fatal("node belongs to an arena document");
+    if (root->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (patch->kind != CSON_ARRAY) return false;
+    cson_nodes_t ops = cson_to_array(patch);
+    for (size_t i = 0; i < ops.len; i++) {
+        if (!cson__patch_op(root, &ops.items[i])) return false;
+    }
+    return true;
 }
 
-CSONDEF void cson_free(cson_node_t *root) {
-    if (!root) return;
-    if (root->key) free(root->key);
-    switch (root->kind) {
-    case CSON_NULL:
-    case CSON_BOOLEAN:
-    case CSON_NUMBER:
-        break;
-    case CSON_STRING:
-        if (root->as.string) free(root->as.string);
-        break;
-    case CSON_ARRAY:
-    case CSON_OBJECT:
-        for (size_t i = 0; i < root->as.container.len; i++) {
-            cson_node_t *node = &root->as.container.items[i];
-            cson_free(node);
+// cson__merge_diff - fill a merge patch with the members that changed
+// @d: diff state
+// @a: old object
+// @ai: digest position of a
+// @b: new object
+// @bi: digest position of b
+// @out: merge patch object of this level
+static void cson__merge_diff(cson__diff_t *d, const cson_node_t *a, size_t ai,
+                             const cson_node_t *b, size_t bi, cson_node_t *out) {
+    cson_nodes_t x = cson_to_object(a), y = cson_to_object(b);
+    size_t base = cson__diff_positions(d, &d->from, x, ai + 1);
+    for (size_t i = 0; i < x.len; i++) {
+        if (!cson_query(b, x.items[i].key)) cson_append(out, cson_create_null(x.items[i].key));
+    }
+    size_t p = bi + 1;
+    for (size_t i = 0; i < y.len; i++) {
+        const cson_node_t *item = &y.items[i];
+        const cson_node_t *other = cson_query(a, item->key);
+        size_t oi = other ? d->pos[base + (size_t) (other - x.items)] : 0;
+        if (!other) {
+            cson_append(out, cson__clone(item, item->key));
+        } else if (cson__diff_same(d, other, oi, item, p)) {
+            // unchanged
+        } else if (other->kind == CSON_OBJECT && item->kind == CSON_OBJECT) {
+            cson_node_t sub = cson_create_object(item->key);
+            cson__merge_diff(d, other, oi, item, p, &sub);
+            cson_append(out, sub);
+        } else {
+            cson_append(out, cson__clone(item, item->key));
         }
-        if (root->as.container.items) free(root->as.container.items);
-        break;
-    default: cson__fatal("unreachable");
+        p += d->to.items[p].size;
     }
+    d->pos_len = base;
 }
 
-CSONDEF cson_node_t *cson_query(const cson_node_t *root, const char *key) {
-    if (root->kind != CSON_OBJECT) cson__fatal("query node should be an object");
-    if (!key) return NULL;
-    for (size_t i = 0; i < root->as.container.len; i++) {
-        cson_node_t *node = &root->as.container.items[i];
-        if (strcmp(node->key, key) == 0) return node;
+CSONDEF cson_node_t cson_merge_diff(const cson_node_t *from, const cson_node_t *to) {
+    if (from->kind != CSON_OBJECT || to->kind != CSON_OBJECT) return cson__clone(to, NULL);
+    cson__diff_t d;
+    cson__diff_init(&d, from, to);
+    d.patch = cson_create_object(NULL);
+    cson__merge_diff(&d, from, 0, to, 0, &d.patch);
+    cson__diff_release(&d);
+    return d.patch;
+}
+
+CSONDEF void cson_merge_apply(cson_node_t *root, const cson_node_t *patch) {
+    if (root->flags & CSON_FLAG_ARENA) cson__fatal("node belongs to an arena document");
+    if (root->flags & CSON_FLAG_FROZEN) cson__fatal("node is frozen");
+    if (patch->kind != CSON_OBJECT) {
+        cson__assign(root, patch);
+        return;
+    }
+    if (root->kind != CSON_OBJECT) {
+        cson_node_t empty = cson_create_object(NULL);
+        cson__assign(root, &empty);
+    }
+    cson_nodes_t members = cson_to_object(patch);
+    for (size_t i = 0; i < members.len; i++) {
+        const cson_node_t *member = &members.items[i];
+        cson_node_t *existing = cson_query(root, member->key);
+        if (member->kind == CSON_NULL) {
+            if (existing) cson_remove_with_key(root, member->key);
+        } else if (existing) {
+            cson_merge_apply(existing, member);
+        } else if (member->kind == CSON_OBJECT) {
+            cson_merge_apply(cson_append_new(root, CSON_OBJECT, member->key), member);
+        } else {
+            cson_append(root, cson__clone(member, member->key));
+        }
     }
-    return NULL;
 }
 
-CSONDEF cson_nodes_t cson_to_object(const cson_node_t *node) {
-    if (node->kind != CSON_OBJECT) cson__fatal("should be an object node");
-    return node->as.container;
+CSONDEF void cson_freeze(cson_node_t *root) {
+    root->flags |= CSON_FLAG_FROZEN;
+    if (root->kind != CSON_OBJECT && root->kind != CSON_ARRAY) return;
+    if (root->flags & CSON_FLAG_LAZY) cson__materialize(root);
+    for (size_t i = 0; i < root->as.container.len; i++) cson_freeze(&root->as.container.items[i]);
 }
 
-CSONDEF cson_nodes_t cson_to_array(const cson_node_t *node) {
-    if (node->kind != CSON_ARRAY) cson__fatal("should be an array node");
-    return node->as.container;
+struct cson_shared {
+    size_t refs;
+    const cson_node_t *root;
+    cson_shared_t *parent; // document a subtree view belongs to (Nullable)
+    cson_node_t tree;      // owned heap tree
+    cson_doc_t doc;        // owned arena document
+};
+
+CSONDEF cson_shared_t *cson_share(cson_node_t *root) {
+    if (root->flags & CSON_FLAG_ARENA) cson__fatal("share arena documents with cson_share_doc");
+    cson_freeze(root);
+    cson_shared_t *doc = (cson_shared_t *) cson__calloc(1, sizeof(cson_shared_t));
+    doc->refs = 1;
+    doc->tree = *root;
+    doc->root = &doc->tree;
+    memset(root, 0, sizeof(*root));
+    return doc;
 }
 
-CSONDEF double cson_to_number(const cson_node_t *node) {
-    if (node->kind != CSON_NUMBER) cson__fatal("should be an number node");
-    return node->as.number;
+CSONDEF cson_shared_t *cson_share_doc(cson_doc_t *doc) {
+    // lazy nodes point back at doc, parse them before it moves
+    cson_freeze(&doc->root);
+    cson_shared_t *shared = (cson_shared_t *) cson__calloc(1, sizeof(cson_shared_t));
+    shared->refs = 1;
+    shared->doc = *doc;
+    shared->root = &shared->doc.root;
+    memset(doc, 0, sizeof(*doc));
+    return shared;
 }
 
-CSONDEF bool cson_to_boolean(const cson_node_t *node) {
-    if (node->kind != CSON_BOOLEAN) cson__fatal("should be an boolean node");
-    return node->as.boolean;
+CSONDEF cson_shared_t *cson_shared_sub(cson_shared_t *doc, const cson_node_t *node) {
+    cson_shared_t *view = (cson_shared_t *) cson__calloc(1, sizeof(cson_shared_t));
+    view->refs = 1;
+    view->root = node;
+    view->parent = cson_shared_retain(doc);
+    return view;
 }
 
-CSONDEF const char *cson_to_string(const cson_node_t *node) {
-    if (node->kind != CSON_STRING) cson__fatal("should be an string node");
-    return node->as.string;
+CSONDEF const cson_node_t *cson_shared_root(const cson_shared_t *doc) {
+    return doc->root;
 }
 
-CSONDEF void cson_remove_with_key(cson_node_t *node, const char *key) {
-    if (node->kind != CSON_OBJECT) cson__fatal("should be an object node");
-    cson_node_t *removed_node = cson_query(node, key);
-    if (!removed_node) return;
-    *removed_node = node->as.container.items[node->as.container.len-1];
-    node->as.container.len--;
+CSONDEF cson_shared_t *cson_shared_retain(cson_shared_t *doc) {
+    cson__atomic_add(&doc->refs, 1);
+    return doc;
 }
 
-CSONDEF void cson_remove_with_idx(cson_node_t *node, size_t idx) {
-    if (node->kind != CSON_ARRAY) cson__fatal("should be an object or array node");
-    if (idx >= node->as.container.len) cson__fatal("index out of range");
-    node->as.container.items[idx] = node->as.container.items[node->as.container.len-1];
-    node->as.container.len--;
+CSONDEF void cson_shared_release(cson_shared_t *doc) {
+    while (doc && cson__atomic_sub(&doc->refs, 1) == 0) {
+        cson_shared_t *parent = doc->parent;
+        if (!parent) {
+            cson_free(&doc->tree);
+            cson_doc_free(&doc->doc);
+        }
+        cson__free(doc);
+        doc = parent;
+    }
 }
 
-CSONDEF void cson_remove_all(cson_node_t *node) {
-    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) {
-        cson__fatal("should be an object or array node");
+CSONDEF void cson_rcu_init(cson_rcu_t *rcu, cson_shared_t *doc) {
+    memset(rcu, 0, sizeof(*rcu));
+    rcu->current = doc;
+}
+
+CSONDEF cson_shared_t *cson_rcu_acquire(cson_rcu_t *rcu) {
+    // count this acquire in the bucket of the current epoch, checked after
+    // counting: a swap stores the new pointer, flips the epoch and frees the
+    // old document once the bucket of the previous epoch has drained, so a
+    // pointer loaded here is either the new one or not freed yet
+    size_t epoch;
+    while (1) {
+        epoch = cson__atomic_load_seq(&rcu->epoch);
+        cson__atomic_add(&rcu->readers[epoch & 1], 1);
+        if (cson__atomic_load_seq(&rcu->epoch) == epoch) break;
+        cson__atomic_sub(&rcu->readers[epoch & 1], 1);
     }
-    node->as.container.len = 0;
+    epoch &= 1;
+    cson_shared_t *doc = (cson_shared_t *) cson__atomic_load_ptr(&rcu->current);
+    if (doc) cson_shared_retain(doc);
+    cson__atomic_sub(&rcu->readers[epoch], 1);
+    return doc;
+}
+
+CSONDEF void cson_rcu_swap(cson_rcu_t *rcu, cson_shared_t *doc) {
+    while (cson__atomic_add(&rcu->writer, 1) != 1) {
+        cson__atomic_sub(&rcu->writer, 1);
+        cson__yield();
+    }
+    cson_shared_t *old = (cson_shared_t *) cson__atomic_xchg_ptr(&rcu->current, doc);
+    size_t epoch = cson__atomic_load_seq(&rcu->epoch) & 1;
+    cson__atomic_add(&rcu->epoch, 1);
+    while (cson__atomic_load_seq(&rcu->readers[epoch]) != 0) cson__yield();
+    cson__atomic_sub(&rcu->writer, 1);
+    cson_shared_release(old);
+}
+
+CSONDEF void cson_rcu_free(cson_rcu_t *rcu) {
+    cson_shared_release(rcu->current);
+    rcu->current = NULL;
 }
 
 #endif
@@ -0,0 +1,305 @@
+/// benchmark parse, query, serialize and free
+///
+/// usage: ./bench [--csv] [file.json ...]
+/// without files a synthetic corpus (deep, wide, numbers, strings) is generated,
+/// run every corpus in its own process to get its own peak RSS
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// count the allocations of the library through its allocator hooks
+static size_t bench_allocs;
+static size_t bench_bytes;
+
+static void *bench_malloc(size_t size) {
+    bench_allocs++;
+    bench_bytes += size;
+    return malloc(size);
+}
+
+static void *bench_realloc(void *p, size_t size) {
+    bench_allocs++;
+    bench_bytes += size;
+    return realloc(p, size);
+}
+
+#define CSON_MALLOC(size) bench_malloc(size)
+#define CSON_REALLOC(p, size) bench_realloc(p, size)
+#define CSON_FREE(p) free(p)
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+// stop repeating a measure after this many seconds
+#define BENCH_TIME 0.5
+#define BENCH_RUNS 20
+
+static bool bench_csv;
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1e-9*(double) ts.tv_nsec;
+}
+
+static long bench_peak_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// growable text buffer of the synthetic generator
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} bench_text_t;
+
+static void text_put(bench_text_t *t, const char *s, size_t n) {
+    if (t->len + n + 1 > t->cap) {
+        while (t->len + n + 1 > t->cap) t->cap = t->cap ? 2*t->cap : 1 << 16;
+        t->data = (char *) realloc(t->data, t->cap);
+        if (!t->data) abort();
+    }
+    memcpy(t->data + t->len, s, n);
+    t->len += n;
+    t->data[t->len] = '\0';
+}
+
+static void text_puts(bench_text_t *t, const char *s) {
+    text_put(t, s, strlen(s));
+}
+
+static void text_printf(bench_text_t *t, const char *fmt, double a, double b) {
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf), fmt, a, b);
+    text_put(t, buf, (size_t) n);
+}
+
+static unsigned bench_rand_state = 12345;
+
+static unsigned bench_rand(void) {
+    bench_rand_state = bench_rand_state*1103515245u + 12345u;
+    return bench_rand_state >> 8;
+}
+
+// nested containers, like config trees, 50 levels deep and repeated
+static void gen_deep(bench_text_t *t) {
+    text_puts(t, "{\"deep\": [");
+    for (int r = 0; r < 20000; r++) {
+        if (r) text_puts(t, ",");
+        for (int d = 0; d < 50; d++) text_puts(t, d % 2 ? "[" : "{\"k\": ");
+        text_puts(t, "1");
+        for (int d = 49; d >= 0; d--) text_puts(t, d % 2 ? "]" : "}");
+    }
+    text_puts(t, "]}");
+}
+
+// one huge object, like an id -> record map
+static void gen_wide(bench_text_t *t) {
+    text_puts(t, "{");
+    for (int i = 0; i < 300000; i++) {
+        text_printf(t, i ? ", \"key%.0f\": %.0f" : "\"key%.0f\": %.0f", i, bench_rand() % 100000);
+    }
+    text_puts(t, "}");
+}
+
+// coordinate arrays, like canada.json, half of them with all 17 digits
+static void gen_numbers(bench_text_t *t) {
+    text_puts(t, "{\"type\": \"Polygon\", \"coordinates\": [");
+    for (int i = 0; i < 400000; i++) {
+        double x = -180.0 + (bench_rand() % 36000000)/100000.0;
+        double y = -90.0 + (bench_rand() % 18000000)/100000.0;
+        text_printf(t, i ? ", [%.15g, %.17g]" : "[%.15g, %.17g]", x, y);
+    }
+    text_puts(t, "]}");
+}
+
+// records of short and long strings, like twitter.json
+static void gen_strings(bench_text_t *t) {
+    static const char *words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "\\u00e9t\\u00e9", "\\\"quoted\\\"", "tab\\t"};
+    text_puts(t, "{\"statuses\": [");
+    for (int i = 0; i < 60000; i++) {
+        text_printf(t, i ? ", {\"id\": %.0f, \"lang\": \"en\", \"text\": \"" : "{\"id\": %.0f, \"lang\": \"en\", \"text\": \"", i, 0);
+        int n = 5 + (int) (bench_rand() % 30);
+        for (int w = 0; w < n; w++) {
+            if (w) text_puts(t, " ");
+            text_puts(t, words[bench_rand() % 8]);
+        }
+        text_puts(t, "\", \"user\": {\"name\": \"user\", \"verified\": false, \"url\": null}}");
+    }
+    text_puts(t, "]}");
+}
+
+// bench_walk - query every member of every object by its key
+static size_t bench_walk(const cson_node_t *node) {
+    size_t found = 0;
+    if (node->kind != CSON_OBJECT && node->kind != CSON_ARRAY) return 0;
+    const cson_nodes_t *da = &node->as.container;
+    for (size_t i = 0; i < da->len; i++) {
+        const cson_node_t *item = &da->items[i];
+        if (node->kind == CSON_OBJECT && cson_query(node, item->key) == item) found++;
+        found += bench_walk(item);
+    }
+    return found;
+}
+
+static bool bench_sink(void *user, const char *data, size_t len) {
+    (void) data;
+    *(size_t *) user += len;
+    return true;
+}
+
+static void bench_report(const char *corpus, const char *op, size_t bytes, double seconds,
+                         size_t allocs, size_t alloc_bytes) {
+    double mbs = (double) bytes/(1024.0*1024.0)/seconds;
+    if (bench_csv) {
+        printf("%s,%s,%.3f,%.6f,%zu,%zu,%ld\n", corpus, op, mbs, seconds, allocs, alloc_bytes,
+               bench_peak_rss_kb());
+    } else {
+        printf("  %-12s %9.1f MB/s %10.3f ms %10zu allocs %8.1f MB alloc\n", op, mbs, 1e3*seconds,
+               allocs, (double) alloc_bytes/(1024.0*1024.0));
+    }
+}
+
+// bench_corpus - measure every operation on one document
+// @name: corpus name
+// @text: NUL-terminated json text
+// @len: text length
+// @path: file holding the same text for cson_load_file (Nullable)
+static void bench_corpus(const char *name, const char *text, size_t len, const char *path) {
+    if (!bench_csv) printf("%s: %.1f MB\n", name, (double) len/(1024.0*1024.0));
+    double best = 1e30, start = bench_now();
+    size_t allocs = 0, bytes = 0;
+    for (int r = 0; r < BENCH_RUNS && (r < 3 || bench_now() - start < BENCH_TIME); r++) {
+        size_t a0 = bench_allocs, b0 = bench_bytes;
+        double t0 = bench_now();
+        cson_node_t root = cson_load_buffer(text);
+        double t = bench_now() - t0;
+        allocs = bench_allocs - a0;
+        bytes = bench_bytes - b0;
+        if (t < best) best = t;
+        cson_free(&root);
+    }
+    bench_report(name, "load_buffer", len, best, allocs, bytes);
+
+    if (path) {
+        best = 1e30;
+        start = bench_now();
+        for (int r = 0; r < BENCH_RUNS && (r < 3 || bench_now() - start < BENCH_TIME); r++) {
+            size_t a0 = bench_allocs, b0 = bench_bytes;
+            double t0 = bench_now();
+            cson_node_t root = cson_load_file(path);
+            double t = bench_now() - t0;
+            allocs = bench_allocs - a0;
+            bytes = bench_bytes - b0;
+            if (t < best) best = t;
+            cson_free(&root);
+        }
+        bench_report(name, "load_file", len, best, allocs, bytes);
+    }
+
+    cson_node_t root = cson_load_buffer(text);
+
+    size_t out = 0;
+    best = 1e30;
+    start = bench_now();
+    for (int r = 0; r < BENCH_RUNS && (r < 3 || bench_now() - start < BENCH_TIME); r++) {
+        size_t a0 = bench_allocs, b0 = bench_bytes;
+        out = 0;
+        double t0 = bench_now();
+        cson_write_to_sink(&root, bench_sink, &out, NULL);
+        double t = bench_now() - t0;
+        allocs = bench_allocs - a0;
+        bytes = bench_bytes - b0;
+        if (t < best) best = t;
+    }
+    bench_report(name, "write", out, best, allocs, bytes);
+
+    FILE *null = fopen("/dev/null", "wb");
+    if (null) {
+        double t0 = bench_now();
+        cson_write(&root, null);
+        bench_report(name, "write_file", out, bench_now() - t0, 0, 0);
+        fclose(null);
+    }
+
+    size_t found = 0;
+    best = 1e30;
+    start = bench_now();
+    for (int r = 0; r < BENCH_RUNS && (r < 3 || bench_now() - start < BENCH_TIME); r++) {
+        double t0 = bench_now();
+        found = bench_walk(&root);
+        double t = bench_now() - t0;
+        if (t < best) best = t;
+    }
+    bench_report(name, "query", len, best, 0, 0);
+    if (!bench_csv) printf("  %-12s %9.1f ns/query (%zu keys)\n", "", found ? 1e9*best/(double) found : 0.0, found);
+
+    double t0 = bench_now();
+    cson_free(&root);
+    bench_report(name, "free", len, bench_now() - t0, 0, 0);
+    if (!bench_csv) printf("  %-12s %9ld KB peak rss\n", "", bench_peak_rss_kb());
+}
+
+// bench_read - read a whole file
+// @path: file path
+// @len: file size
+// Return: NUL-terminated content, NULL on error
+static char *bench_read(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *data = size > 0 ? (char *) malloc((size_t) size + 1) : NULL;
+    if (!data || fread(data, (size_t) size, 1, f) != 1) {
+        fclose(f);
+        free(data);
+        return NULL;
+    }
+    fclose(f);
+    data[size] = '\0';
+    *len = (size_t) size;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "--csv") == 0) {
+        bench_csv = true;
+        first = 2;
+        printf("corpus,op,mb_per_s,seconds,allocs,alloc_bytes,peak_rss_kb\n");
+    }
+
+    if (first >= argc) {
+        static const struct {
+            const char *name;
+            void (*gen)(bench_text_t *t);
+        } synthetic[] = {
+            {"deep", gen_deep}, {"wide", gen_wide}, {"numbers", gen_numbers}, {"strings", gen_strings},
+        };
+        for (size_t i = 0; i < sizeof(synthetic)/sizeof(synthetic[0]); i++) {
+            bench_text_t t = {NULL, 0, 0};
+            synthetic[i].gen(&t);
+            bench_corpus(synthetic[i].name, t.data, t.len, NULL);
+            free(t.data);
+        }
+        return 0;
+    }
+
+    for (int i = first; i < argc; i++) {
+        size_t len = 0;
+        char *text = bench_read(argv[i], &len);
+        if (!text) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        bench_corpus(argv[i], text, len, argv[i]);
+        free(text);
+    }
+    return 0;
+}
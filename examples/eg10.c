@@ -0,0 +1,36 @@
+/// ship only what changed between two versions of a config
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+static const char *v1 = "{\"service\": \"api\", \"replicas\": 3,"
+                        " \"hosts\": [\"a.internal\", \"b.internal\"],"
+                        " \"limits\": {\"cpu\": 2, \"memory\": 512}}";
+static const char *v2 = "{\"service\": \"api\", \"replicas\": 4,"
+                        " \"hosts\": [\"a.internal\", \"c.internal\", \"b.internal\"],"
+                        " \"limits\": {\"cpu\": 2}}";
+
+int main(void) {
+    cson_node_t from = cson_load_buffer(v1);
+    cson_node_t to = cson_load_buffer(v2);
+
+    // JSON Patch, applied on a node that still holds v1
+    cson_node_t patch = cson_diff(&from, &to);
+    cson_write(&patch, stdout);
+    printf("\n");
+    cson_node_t node = cson_clone(&from);
+    if (!cson_patch_apply(&node, &patch)) return 1;
+    printf("replicas: %d\n", (int) cson_to_number(cson_query(&node, "replicas")));
+
+    // JSON Merge Patch of the same change
+    cson_node_t merge = cson_merge_diff(&from, &to);
+    cson_write(&merge, stdout);
+    printf("\n");
+
+    cson_free(&merge);
+    cson_free(&node);
+    cson_free(&patch);
+    cson_free(&to);
+    cson_free(&from);
+    return 0;
+}
@@ -0,0 +1,28 @@
+/// write a large export record by record, no tree is built
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+int main(void) {
+    cson_stream_t *s = cson_stream_open_file(stdout, NULL);
+    cson_stream_begin_object(s);
+    cson_stream_key(s, "users");
+    cson_stream_begin_array(s);
+    for (int i = 0; i < 3; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "user \"%d\"", i); // quotes are escaped
+        cson_stream_begin_object(s);
+        cson_stream_key(s, "id");
+        cson_stream_int64(s, i);
+        cson_stream_key(s, "name");
+        cson_stream_string(s, name);
+        cson_stream_key(s, "active");
+        cson_stream_boolean(s, i % 2 == 0);
+        cson_stream_end_object(s);
+    }
+    cson_stream_end_array(s);
+    cson_stream_end_object(s);
+    bool ok = cson_stream_close(s);
+    printf("\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+/// incremental deserialize
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+int main(void) {
+    FILE *f = fopen("test.json", "rb");
+    if (!f) return 1;
+
+    // any chunk size works, tokens split between two reads are completed later
+    char chunk[7];
+    size_t n;
+    cson_parser_t parser;
+    cson_parser_init(&parser);
+    while (!cson_parser_done(&parser) && (n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        cson_parser_feed(&parser, chunk, n);
+    }
+    fclose(f);
+
+    cson_node_t root = cson_parser_finish(&parser);
+    cson_write(&root, stdout);
+    cson_free(&root);
+    return 0;
+}
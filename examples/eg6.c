@@ -0,0 +1,38 @@
+/// deserialize into callbacks
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+typedef struct {
+    bool in_id; // the next value belongs to an "id" key
+    int64_t sum;
+    size_t ids;
+} id_sum_t;
+
+static bool on_key(void *user, const char *key, size_t len) {
+    id_sum_t *s = (id_sum_t *) user;
+    s->in_id = len == 2 && memcmp(key, "id", 2) == 0;
+    return true;
+}
+
+static bool on_integer(void *user, int64_t value) {
+    id_sum_t *s = (id_sum_t *) user;
+    if (s->in_id) {
+        s->sum += value;
+        s->ids++;
+    }
+    return true;
+}
+
+int main(void) {
+    cson_handler_t handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.key = on_key;
+    handler.integer = on_integer;
+
+    id_sum_t s;
+    memset(&s, 0, sizeof(s));
+    cson_parse_events_file("test.json", &handler, &s);
+    printf("%zu ids, sum: %lld\n", s.ids, (long long) s.sum);
+    return 0;
+}
@@ -0,0 +1,23 @@
+/// query nested values with paths
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+int main(void) {
+    cson_node_t root = cson_load_file("test.json");
+
+    // compile once, run on every post
+    cson_path_t title = cson_path_compile("title");
+    cson_path_t role = cson_path_compile("/metadata/author/role");
+    cson_nodes_t posts = cson_to_array(cson_query_path(&root, "api.data.posts"));
+    for (size_t i = 0; i < posts.len; i++) {
+        printf("%s by %s\n", cson_to_string(cson_path_eval(&title, &posts.items[i])),
+               cson_to_string(cson_path_eval(&role, &posts.items[i])));
+    }
+    cson_path_free(&title);
+    cson_path_free(&role);
+
+    printf("last hobby: %s\n", cson_to_string(cson_query_path(&root, "api.data.user.hobbies[2]")));
+    cson_free(&root);
+    return 0;
+}
@@ -0,0 +1,83 @@
+/// deserialize straight into structs with a schema
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+struct address_t {
+    char city[32];
+    char zipcode[8];
+};
+
+struct profile_t {
+    int64_t age;
+    address_t address;
+};
+
+struct user_t {
+    int64_t id;
+    char *name;
+    profile_t profile;
+};
+
+struct data_t {
+    user_t user;
+};
+
+struct api_t {
+    char status[16];
+    int64_t code;
+    data_t data;
+};
+
+struct doc_t {
+    api_t api;
+};
+
+static const cson_field_t address_fields[] = {
+    CSON_FIELD_OF(address_t, city),
+    CSON_FIELD_OF(address_t, zipcode),
+};
+static const cson_schema_t address_schema = CSON_SCHEMA(address_fields);
+
+static const cson_field_t profile_fields[] = {
+    CSON_FIELD_OF(profile_t, age),
+    CSON_FIELD_NESTED(profile_t, address, &address_schema),
+};
+static const cson_schema_t profile_schema = CSON_SCHEMA(profile_fields);
+
+static const cson_field_t user_fields[] = {
+    CSON_FIELD_OF(user_t, id),
+    CSON_FIELD_OF(user_t, name),
+    CSON_FIELD_NESTED(user_t, profile, &profile_schema),
+};
+static const cson_schema_t user_schema = CSON_SCHEMA(user_fields);
+
+static const cson_field_t data_fields[] = {
+    CSON_FIELD_NESTED(data_t, user, &user_schema),
+};
+static const cson_schema_t data_schema = CSON_SCHEMA(data_fields);
+
+static const cson_field_t api_fields[] = {
+    CSON_FIELD_OF(api_t, status),
+    CSON_FIELD_OF(api_t, code),
+    CSON_FIELD_NESTED(api_t, data, &data_schema),
+};
+static const cson_schema_t api_schema = CSON_SCHEMA(api_fields);
+
+static const cson_field_t doc_fields[] = {
+    CSON_FIELD_NESTED(doc_t, api, &api_schema),
+};
+static const cson_schema_t doc_schema = CSON_SCHEMA(doc_fields);
+
+int main() {
+    doc_t doc;
+    memset(&doc, 0, sizeof(doc));
+    // "posts", "hobbies" and the other members are skipped
+    cson_parse_schema_file("test.json", &doc_schema, &doc);
+
+    const user_t *user = &doc.api.data.user;
+    printf("%s %d: user %d %s, %d, %s %s\n", doc.api.status, (int) doc.api.code, (int) user->id,
+           user->name, (int) user->profile.age, user->profile.address.city, user->profile.address.zipcode);
+    free(user->name);
+    return 0;
+}
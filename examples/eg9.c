@@ -0,0 +1,31 @@
+/// reject bad payloads without aborting
+
+#define CSON_IMPLEMENTATION
+#include "cson.h"
+
+static const char *payloads[] = {
+    "{\"user\": \"Jane\", \"age\": 32}",
+    "{\"user\": \"Jane\",\n \"age\": 32,\n}",
+    "{\"user\": \"Jane\", \"age\": 3 2}",
+    "{\"user\": \"Jane",
+};
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(payloads)/sizeof(payloads[0]); i++) {
+        const char *text = payloads[i];
+        cson_node_t root;
+        cson_error_t err;
+        if (!cson_try_load_buffer(text, strlen(text), &root, &err)) {
+            printf("payload %zu: %s at line %zu, column %zu\n", i, cson_error_string(err.code),
+                   err.line, err.column);
+            continue;
+        }
+        printf("payload %zu: age %d\n", i, (int) cson_to_number(cson_query(&root, "age")));
+        cson_free(&root);
+    }
+
+    // check only, nothing is built
+    const char *text = payloads[1];
+    printf("valid: %s\n", cson_validate(text, strlen(text), NULL) ? "yes" : "no");
+    return 0;
+}